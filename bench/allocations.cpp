@@ -0,0 +1,319 @@
+//
+// Created by terae on 19/10/26.
+//
+
+#include "Cell.hpp"
+#include "HeatmapCell.hpp"
+#include "HistogramCell.hpp"
+#include "RateCell.hpp"
+#include "StaticTerminal.hpp"
+#include "TaskProgressCell.hpp"
+#include "TextCell.hpp"
+#include "VirtualTerminal.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <fcntl.h>
+#include <functional>
+#include <new>
+#include <string>
+#include <string_view>
+#include <sys/ioctl.h>
+#include <thread>
+#include <unistd.h>
+
+using namespace AwesomeViewer;
+
+namespace {
+    // Only the allocations of the measuring thread are counted, not the ones of the executor
+    thread_local bool counting = false;
+    thread_local std::size_t allocations = 0;
+    thread_local std::size_t allocated_bytes = 0;
+
+    void *allocate(std::size_t size, std::size_t alignment = 0) {
+        if (counting) {
+            ++allocations;
+            allocated_bytes += size;
+        }
+        void *p = (alignment > alignof(std::max_align_t) ?
+                   std::aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment) :
+                   std::malloc(size == 0 ? 1 : size));
+        if (p == nullptr) {
+            throw std::bad_alloc();
+        }
+        return p;
+    }
+
+    struct Measure {
+        std::string_view name;
+        // Maximum number of allocations of a steady-state frame
+        std::size_t budget;
+        std::function<void()> frame;
+        // Whether the frame is written to a terminal, instead of /dev/null
+        bool terminal = false;
+    };
+
+    constexpr int warm_up_frames = 20;
+    constexpr int measured_frames = 200;
+
+    struct Result {
+        double allocations;
+        double bytes;
+        std::size_t highest;
+    } result;
+
+    bool run(const Measure &measure) {
+        for (int i = 0; i < warm_up_frames; ++i) {
+            measure.frame();
+        }
+
+        std::size_t total = 0, total_bytes = 0, highest = 0;
+        for (int i = 0; i < measured_frames; ++i) {
+            allocations = allocated_bytes = 0;
+            counting = true;
+            measure.frame();
+            counting = false;
+            total += allocations;
+            total_bytes += allocated_bytes;
+            highest = std::max(highest, allocations);
+        }
+
+        result = {static_cast<double>(total) / measured_frames, static_cast<double>(total_bytes) / measured_frames,
+                  highest
+                 };
+        return highest <= measure.budget;
+    }
+
+    void print(const Measure &measure, bool ok) {
+        std::printf("%-36s %8.1f allocs/frame %10.1f bytes/frame %6zu max %6zu budget  %s\n",
+                    std::string(measure.name).c_str(), result.allocations, result.bytes, result.highest, measure.budget,
+                    ok ? "ok" : "OVER BUDGET");
+    }
+}
+
+void *operator new(std::size_t size) {
+    return allocate(size);
+}
+
+void *operator new[](std::size_t size) {
+    return allocate(size);
+}
+
+void *operator new(std::size_t size, std::align_val_t alignment) {
+    return allocate(size, static_cast<std::size_t>(alignment));
+}
+
+void *operator new[](std::size_t size, std::align_val_t alignment) {
+    return allocate(size, static_cast<std::size_t>(alignment));
+}
+
+void operator delete(void *p) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void *p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void *p, std::size_t) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void *p, std::size_t) noexcept {
+    std::free(p);
+}
+
+void operator delete(void *p, std::align_val_t) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void *p, std::align_val_t) noexcept {
+    std::free(p);
+}
+
+void operator delete(void *p, std::size_t, std::align_val_t) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void *p, std::size_t, std::align_val_t) noexcept {
+    std::free(p);
+}
+
+/**
+ * Allocations per steady-state frame of each cell type and of the terminals.
+ * Fails if a frame allocates more than its budget: lower the budgets as the allocations are removed. The terminals
+ * printing inline don't allocate by themselves: their budget is the one of their cells.
+ * With `--report`, only prints the measures.
+ */
+int main(int argc, char *argv[]) {
+    const bool report_only = argc > 1 && std::string_view(argv[1]) == "--report";
+    int timer = 0;
+
+    StringCell string_cell(30, 3, [&timer]() {
+        return "Frame " + std::to_string(timer) + "\nof the allocation test";
+    });
+    StringCell constant_cell(30, 3, std::string("Constant\ncontent"));
+    ProgressCell progress_cell(30, 1, [&timer]() {
+        return static_cast<double>(timer % 101);
+    });
+    MapCell<int> map_cell(30, 3, [&timer]() {
+        return std::map<std::string, int> {{"frame", timer}, {"double", 2 * timer}, {"constant", 42}};
+    });
+
+    LatencyHistogram histogram;
+    HistogramCell histogram_cell(40, 5, histogram);
+    Counter counter;
+    RateCell rate_cell(40, 2, {{"events", &counter}});
+    TaskSet tasks(1000, 1000000);
+    TaskProgressCell task_cell(40, 6, tasks);
+    TextCell text_cell(40, 10);
+    std::vector<float> matrix(200 * 200);
+    HeatmapCell heatmap_cell(40, 10, [&matrix, &timer]() {
+        for (std::size_t i = 0; i < matrix.size(); ++i) {
+            matrix[i] = static_cast<float>((i * 7 + static_cast<std::size_t>(timer)) % 101);
+        }
+        return MatrixView(matrix.data(), 200, 200);
+    }, HeatmapCell::Palette::Extended);
+
+    VirtualTerminal vt(100, 20);
+    vt.add_cell(string_cell, "String");
+    vt.add_cell(progress_cell, "Progress");
+    vt.add_cell(map_cell, "Map");
+    vt.add_cell(histogram_cell, "Histogram");
+    // Whatever the standard output of the benchmark, as on a terminal
+    vt.set_presentation(Presentation::Inline);
+
+    // Printed in the Snapshot presentation
+    VirtualTerminal snapshot_vt(100, 20);
+    snapshot_vt.add_cell(string_cell, "String");
+    snapshot_vt.add_cell(progress_cell, "Progress");
+    snapshot_vt.add_cell(map_cell, "Map");
+    snapshot_vt.add_cell(histogram_cell, "Histogram");
+    snapshot_vt.set_presentation(Presentation::Snapshot);
+    snapshot_vt.set_snapshot_interval(std::chrono::nanoseconds::zero());
+
+    // Nothing changes from one frame to the next
+    VirtualTerminal unchanged_vt(100, 20);
+    unchanged_vt.add_cell(constant_cell, "Constant");
+    unchanged_vt.set_presentation(Presentation::Inline);
+
+    StaticTerminal static_terminal(100, 20,
+                                   static_string_cell<30, 3>("String", [&timer]() {
+        return "Frame " + std::to_string(timer) + "\nof the allocation test";
+    }),
+    static_progress_cell<30>("Progress", [&timer]() {
+        return static_cast<double>(timer % 101);
+    }));
+
+    std::string frame;
+    auto cell_frame = [&timer, &histogram, &counter, &tasks](AbstractCell &cell) {
+        return [&timer, &histogram, &counter, &tasks, &cell]() {
+            ++timer;
+            histogram.record(static_cast<std::uint64_t>(timer) * 1000);
+            counter.add(10);
+            tasks.advance(static_cast<std::size_t>(timer) % tasks.size(), 100);
+            cell.update();
+        };
+    };
+
+    constexpr std::size_t string_budget = 40;
+    constexpr std::size_t constant_budget = 3;
+    constexpr std::size_t progress_budget = 6;
+    constexpr std::size_t map_budget = 40;
+    constexpr std::size_t histogram_budget = 28;
+    // The cells of `vt`
+    constexpr std::size_t cells_budget = string_budget + progress_budget + map_budget + histogram_budget;
+
+    const Measure measures[] = {
+        {"StringCell", string_budget, cell_frame(string_cell)},
+        {"StringCell (constant)", constant_budget, cell_frame(constant_cell)},
+        {"ProgressCell", progress_budget, cell_frame(progress_cell)},
+        {"MapCell<int>", map_budget, cell_frame(map_cell)},
+        {"HistogramCell", histogram_budget, cell_frame(histogram_cell)},
+        {"RateCell", 10, cell_frame(rate_cell)},
+        {"TaskProgressCell", 30, cell_frame(task_cell)},
+        {"HeatmapCell", 80, cell_frame(heatmap_cell)},
+        {
+            "TextCell", 32, [&]() {
+                text_cell.append("A line appended by each frame of the allocation test\n");
+                text_cell.update();
+            }
+        },
+        {
+            "VirtualTerminal::render", cells_budget, [&]() {
+                ++timer;
+                vt.render(frame);
+            }
+        },
+        {
+            "VirtualTerminal::print", cells_budget, [&]() {
+                ++timer;
+                vt.print();
+            }, true
+        },
+        {
+            "VirtualTerminal::print (unchanged)", constant_budget, [&]() {
+                unchanged_vt.print();
+            }, true
+        },
+        {
+            // The frame is also converted to plain text, line by line
+            "VirtualTerminal::print (Snapshot)", cells_budget + 20, [&]() {
+                ++timer;
+                snapshot_vt.print();
+            }
+        },
+        {
+            "StaticTerminal::render", 1, [&]() {
+                ++timer;
+                static_terminal.render(frame);
+            }
+        },
+    };
+
+    // `print` writes the Inline frames to a pseudo-terminal large enough for them, read by another thread
+    const int null = open("/dev/null", O_WRONLY);
+    const int master = posix_openpt(O_RDWR | O_NOCTTY);
+    if (master < 0 || grantpt(master) != 0 || unlockpt(master) != 0) {
+        std::fprintf(stderr, "Unable to open a pseudo-terminal.\n");
+        return 1;
+    }
+    const int terminal = open(ptsname(master), O_WRONLY | O_NOCTTY);
+    winsize size{};
+    size.ws_col = 120;
+    size.ws_row = 30;
+    ioctl(terminal, TIOCSWINSZ, &size);
+    std::thread reader([master]() {
+        char buffer[4096];
+        while (read(master, buffer, sizeof(buffer)) > 0) {
+        }
+    });
+    const int standard_output = dup(STDOUT_FILENO);
+
+    bool ok = true;
+    for (const auto &measure : measures) {
+        std::fflush(stdout);
+        dup2(measure.terminal ? terminal : null, STDOUT_FILENO);
+        const bool measure_ok = run(measure);
+        dup2(standard_output, STDOUT_FILENO);
+        print(measure, measure_ok);
+        ok = measure_ok && ok;
+    }
+    close(null);
+    close(standard_output);
+    // The reader stops once the last descriptor of the terminal is closed
+    close(terminal);
+    reader.join();
+    close(master);
+
+    vt.remove_cell(string_cell);
+    vt.remove_cell(progress_cell);
+    vt.remove_cell(map_cell);
+    vt.remove_cell(histogram_cell);
+    snapshot_vt.remove_cell(string_cell);
+    snapshot_vt.remove_cell(progress_cell);
+    snapshot_vt.remove_cell(map_cell);
+    snapshot_vt.remove_cell(histogram_cell);
+    unchanged_vt.remove_cell(constant_cell);
+    return ok || report_only ? 0 : 1;
+}
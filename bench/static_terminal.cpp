@@ -0,0 +1,75 @@
+//
+// Created by terae on 19/10/26.
+//
+
+#include "Cell.hpp"
+#include "StaticTerminal.hpp"
+#include "VirtualTerminal.hpp"
+#include "utils.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+
+using namespace AwesomeViewer;
+
+/**
+ * Time to update and compose the same dashboard with a `VirtualTerminal` and a `StaticTerminal`.
+ */
+int main() {
+    constexpr int frames = 20000;
+    int timer = 0;
+
+    auto text = [&timer]() {
+        return "Frame " + std::to_string(timer) + "\nof the benchmark";
+    };
+    auto number = [&timer]() {
+        return std::to_string(timer * 7 % 1000);
+    };
+    auto progress = [&timer]() {
+        return static_cast<double>(timer % 101);
+    };
+
+    VirtualTerminal dynamic(80, 12);
+    StringCell c1(20, 2, std::function<std::string()>(text));
+    StringCell c2(10, 1, std::function<std::string()>(number));
+    StringCell c3(30, 1, std::string("Constant content"));
+    ProgressCell c4(24, 1, std::function<double()>(progress));
+    dynamic.add_cell(c1, "Text");
+    dynamic.add_cell(c2, "Number");
+    dynamic.add_cell(c3, "Constant");
+    dynamic.add_cell(c4, "Progress");
+
+    StaticTerminal static_terminal(80, 12,
+                                   static_string_cell<20, 2>("Text", text),
+                                   static_string_cell<10, 1>("Number", number),
+                                   static_string_cell<30, 1>("Constant", []() {
+        return std::string_view("Constant content");
+    }),
+    static_progress_cell<24>("Progress", progress));
+
+    std::string dynamic_frame, static_frame;
+    dynamic.render(dynamic_frame);
+    static_terminal.render(static_frame);
+    const bool identical = strip_escapes(dynamic_frame) == strip_escapes(static_frame);
+
+    auto measure = [&timer](auto &terminal, std::string &frame) {
+        const auto start = std::chrono::steady_clock::now();
+        for (timer = 0; timer < frames; ++timer) {
+            terminal.render(frame);
+        }
+        return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / frames;
+    };
+    const double dynamic_ns = measure(dynamic, dynamic_frame);
+    const double static_ns = measure(static_terminal, static_frame);
+
+    std::printf("Same text displayed: %s\n", identical ? "yes" : "NO");
+    std::printf("VirtualTerminal: %10.0f ns/frame\n", dynamic_ns);
+    std::printf("StaticTerminal:  %10.0f ns/frame (x%.1f)\n", static_ns, dynamic_ns / static_ns);
+
+    dynamic.remove_cell(c1);
+    dynamic.remove_cell(c2);
+    dynamic.remove_cell(c3);
+    dynamic.remove_cell(c4);
+    return identical ? 0 : 1;
+}
@@ -6,6 +6,10 @@
 #define UNTITLED_CELL_H
 
 #include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
 #include <functional>
 #include <iomanip>
 #include <map>
@@ -13,24 +17,108 @@
 #include <sstream>
 #include <vector>
 
+#include "Export.hpp"
+#include "Format.hpp"
 #include "Style.hpp"
 #include "StyleString.hpp"
+#include "Width.hpp"
 
 namespace AwesomeViewer {
 
+    /**
+     * Order in which the cells are updated when the CPU budget of a frame is limited: once it is spent, the remaining
+     * cells keep their previous content, except the critical ones which are always updated.
+     */
+    enum class Priority {
+        Low,
+        Normal,
+        High,
+        Critical
+    };
+
     class AbstractCell {
+      public:
+        using Clock = std::chrono::steady_clock;
+
       protected:
         unsigned int _width, _height;
+        // All the lines of the cell, which can be more than its height: `_scroll` is the first displayed one
         std::vector<StyleString> _data;
+        std::size_t _scroll = 0;
 
         AbstractCell(unsigned int width, unsigned int height) :
-            _width(width), _height(height) {}
+            _width(width), _height(height), _phase(next_phase()) {}
+
+      private:
+        Clock::duration _refresh_interval = Clock::duration::zero();
+        Clock::time_point _next_refresh{};
+        Clock::time_point _last_refresh{};
+        Priority _priority = Priority::Normal;
+        // Fraction of the interval delaying the first scheduled refresh, so that the cells sharing an interval
+        // don't all refresh during the same frame
+        double _phase;
+
+        static double next_phase() {
+            static std::atomic<unsigned int> count{0};
+            return std::fmod(count.fetch_add(1, std::memory_order_relaxed) * 0.6180339887498949, 1.0);
+        }
 
       public:
         virtual ~AbstractCell() = default;
 
         virtual void update() = 0;
 
+        /**
+         * Keep the content of the cell during `interval` instead of calling its generator at each frame.
+         */
+        void set_refresh_interval(Clock::duration interval) {
+            _refresh_interval = interval;
+            _next_refresh = Clock::time_point{};
+        }
+
+        Clock::duration get_refresh_interval() const {
+            return _refresh_interval;
+        }
+
+        void set_priority(Priority priority) {
+            _priority = priority;
+        }
+
+        Priority get_priority() const {
+            return _priority;
+        }
+
+        // Time of the last update, the epoch if the cell has never been updated
+        Clock::time_point get_last_refresh() const {
+            return _last_refresh;
+        }
+
+        bool is_due(Clock::time_point now) const {
+            return _data.empty() || _refresh_interval <= Clock::duration::zero() || now >= _next_refresh;
+        }
+
+        /**
+         * Update the cell if its content expired, and return whether it was.
+         */
+        bool refresh(Clock::time_point now = Clock::now()) {
+            if (!is_due(now)) {
+                return false;
+            }
+            update();
+            _last_refresh = now;
+
+            if (_refresh_interval > Clock::duration::zero()) {
+                if (_next_refresh == Clock::time_point{}) {
+                    _next_refresh = now + std::chrono::duration_cast<Clock::duration>(_refresh_interval * _phase);
+                } else {
+                    // Keep the phase of the cell even if some frames were missed
+                    const auto late = (now - _next_refresh) / _refresh_interval;
+                    _next_refresh += _refresh_interval * (late + 1);
+                }
+            }
+            return true;
+        }
+
         constexpr unsigned int get_height() const {
             return _height;
         }
@@ -39,19 +127,126 @@ namespace AwesomeViewer {
             return _width;
         }
 
-        std::string get_nth_line(std::size_t line) const {
+        bool has_data() const {
+            return !_data.empty();
+        }
+
+        virtual const char *get_type() const {
+            return "cell";
+        }
+
+        /**
+         * Export the content computed by the last `update`, without calling the generator.
+         */
+        virtual void export_to(Exporter &exporter) const {
+            for (const auto &line : _data) {
+                auto text = line.to_plain_string();
+                text.erase(text.find_last_not_of(' ') + 1);
+                exporter.line(text);
+            }
+        }
+
+        std::size_t line_count() const {
+            return _data.size();
+        }
+
+        // Content computed by the last `update`
+        const std::vector<StyleString> &get_lines() const {
+            return _data;
+        }
+
+        /**
+         * Display `lines`, e.g. saved by a previous run, until the first `update`. Ignored once the cell has content.
+         */
+        virtual void restore_lines(std::vector<StyleString> lines) {
             if (_data.empty()) {
-                throw std::runtime_error("You need to update the cell.");
+                _data = std::move(lines);
             }
+        }
+
+        // First displayed line, kept in range when the content shrinks
+        std::size_t get_scroll() const {
+            return std::min(_scroll, _data.size() > _height ? _data.size() - _height : 0);
+        }
+
+        /**
+         * Scroll by `lines`, up if negative, without updating the cell. Only called by the rendering thread.
+         */
+        virtual void scroll(long lines) {
+            const auto last = static_cast<long>(_data.size() > _height ? _data.size() - _height : 0);
+            _scroll = static_cast<std::size_t>(std::clamp(static_cast<long>(get_scroll()) + lines, 0l, last));
+        }
+
+        // A cell which has never been updated is blank
+        std::string get_nth_line(std::size_t line) const {
+            std::string result;
+            append_nth_line(line, result);
+            return result;
+        }
+
+        void append_nth_line(std::size_t line, std::string &out) const {
             if (_height < line) {
                 throw std::range_error("Line out of range.");
             }
-            return _data[line].to_string();
+            line += get_scroll();
+            if (line >= _data.size()) {
+                out.append(_width, ' ');
+                return;
+            }
+            _data[line].append_to(out);
         }
     };
 
     class StringCell final : public AbstractCell {
+        // Wrapped lines of a paragraph of the text, all of them: the lines beyond the height are scrolled to
+        struct Paragraph {
+            std::uint64_t hash;
+            std::vector<StyleString> lines;
+        };
+
         std::function<StyleString()> _data_generator;
+        bool _word_wrap = false;
+        std::uint64_t _content_hash = 0;
+        std::vector<Paragraph> _paragraphs;
+        std::size_t _rewrapped = 0;
+
+        StyleString pad(StyleString line) const {
+            const auto width = line.width();
+            if (width < _width) {
+                line += std::string(_width - width, ' ');
+            }
+            return line;
+        }
+
+        std::vector<StyleString> wrap(const StyleString &paragraph) const {
+            std::vector<StyleString> lines;
+            if (!_word_wrap) {
+                lines.push_back(pad(paragraph.prefix_of_width(_width)));
+                return lines;
+            }
+
+            const std::string text = paragraph.to_plain_string();
+            std::size_t begin = 0;
+            do {
+                const std::string_view rest = std::string_view(text).substr(begin);
+                std::size_t end = begin + AwesomeViewer::prefix_of_width(rest, _width).bytes;
+                if (end == begin && begin < text.size()) {
+                    // A wide character in a narrower cell: skip it rather than looping forever
+                    decode_utf8(text, end);
+                    begin = end;
+                } else if (end < text.size()) {
+                    // Break after the last word fitting in the line, or cut a word longer than the line
+                    auto space = text.find_last_of(' ', end);
+                    if (space != std::string::npos && space > begin) {
+                        end = space;
+                    }
+                }
+                lines.push_back(pad(paragraph.substr(begin, end - begin)));
+
+                begin = text.find_first_not_of(' ', end);
+            } while (begin != std::string::npos);
+            return lines;
+        }
 
         std::vector<std::string> split(const std::string &s, char delimiter) {
             std::vector<std::string> tokens;
@@ -95,7 +290,7 @@ namespace AwesomeViewer {
             auto lines = split(ss.str(), '\n');
             unsigned int width = 0;
             for (std::string str : lines) {
-                width = std::max(width, static_cast<unsigned int>(str.size()));
+                width = std::max(width, static_cast<unsigned int>(display_width(str)));
             }
             return width;
         }(), [value, this]() {
@@ -112,27 +307,55 @@ namespace AwesomeViewer {
 
         ~StringCell() override = default;
 
-        void update() override {
+        const char *get_type() const override {
+            return "string";
+        }
+
+        /**
+         * Wrap the long lines at the spaces instead of truncating them.
+         */
+        void set_word_wrap(bool word_wrap) {
+            _word_wrap = word_wrap;
+            _paragraphs.clear();
             _data.clear();
+        }
+
+        // Number of paragraphs wrapped by the last update which changed the text, the previous ones were cached
+        std::size_t rewrapped_paragraphs() const {
+            return _rewrapped;
+        }
+
+        /**
+         * The wrapped lines are cached: an unchanged text isn't split again, and a changed one is only re-wrapped from
+         * its first modified paragraph. The lines beyond the height are kept to be scrolled to.
+         */
+        void update() override {
             StyleString str = _data_generator();
-            for (unsigned int i = 0; i < _height; ++i) {
-                if (str.empty()) {
-                    _data.emplace_back(Style::Default(), std::string(_width, ' '));
-                } else {
-                    std::size_t eol = str.find_first_of('\n');
-                    StyleString tmp = str.substr(0, std::min(eol, static_cast<std::size_t>(_width)));
-                    if (tmp.size() < _width) {
-                        tmp += std::string(_width - tmp.size(), ' ');
-                    }
+            const auto hash = str.hash();
+            if (!_data.empty() && hash == _content_hash) {
+                return;
+            }
+            _content_hash = hash;
 
-                    if (eol == std::string::npos) {
-                        str.clear();
-                    } else {
-                        str = str.substr(eol + 1);
-                    }
+            const auto paragraphs = str.split_lines();
+            std::size_t kept = 0;
+            while (kept < std::min(paragraphs.size(), _paragraphs.size()) &&
+                    _paragraphs[kept].hash == paragraphs[kept].hash()) {
+                ++kept;
+            }
+            _paragraphs.resize(kept);
+            _rewrapped = paragraphs.size() - kept;
 
-                    _data.push_back(tmp);
-                }
+            for (std::size_t i = kept; i < paragraphs.size(); ++i) {
+                _paragraphs.push_back({paragraphs[i].hash(), wrap(paragraphs[i])});
+            }
+
+            _data.clear();
+            for (const auto &paragraph : _paragraphs) {
+                _data.insert(_data.end(), paragraph.lines.cbegin(), paragraph.lines.cend());
+            }
+            while (_data.size() < _height) {
+                _data.emplace_back(Style::Default(), std::string(_width, ' '));
             }
         }
     };
@@ -140,6 +363,7 @@ namespace AwesomeViewer {
     class ProgressCell final : public AbstractCell {
         double _min;
         double _max;
+        double _value = 0.0;
         std::function<double()> _percent_generator;
         bool _print_percent;
 
@@ -162,9 +386,20 @@ namespace AwesomeViewer {
 
         ~ProgressCell() override = default;
 
+        const char *get_type() const override {
+            return "progress";
+        }
+
+        void export_to(Exporter &exporter) const override {
+            exporter.field("value", _value);
+            exporter.field("min", _min);
+            exporter.field("max", _max);
+        }
+
         void update() override {
             _data.clear();
             double progress = _percent_generator();
+            _value = progress;
             progress = std::min(_max, std::max(_min, progress));
             if (_min < 0) {
                 progress -= _min;
@@ -179,10 +414,10 @@ namespace AwesomeViewer {
             result.insert(Style::Default(), std::string(progress_width - amount, ' '));
 
             if (_print_percent) {
-                std::stringstream ss;
-                ss << std::right << std::setw(3) << static_cast<int>(progress) << '%';
+                std::string percent(4, ' ');
+                format_percent(percent, std::trunc(progress));
 
-                result.insert(Style(FontColor::Black, Font::Bold), ss.str());
+                result.insert(Style(FontColor::Black, Font::Bold), std::move(percent));
             }
             _data.push_back(result);
         }
@@ -191,21 +426,25 @@ namespace AwesomeViewer {
     template<typename T>
     class MapCell final : public AbstractCell {
         std::function<std::map<std::string, T>()> _data_generator;
+        std::map<std::string, T> _map;
+
+        StyleString T_to_string(const T &x, unsigned int size) {
+            if constexpr (std::is_same<T, StyleString>::value) {
+                StyleString str = x.prefix_of_width(size);
+                str += std::string(size - str.width(), ' ');
+                return str;
+            } else if constexpr (std::is_convertible<const T &, std::string_view>::value) {
+                return StyleString(align_to_width(x, size));
+            } else if constexpr (is_formattable<T>) {
+                std::string str(size, ' ');
+                format(str, x);
+                return StyleString(std::move(str));
+            } else {
+                std::stringstream ss;
+                ss << x;
 
-        template<class Q = T>
-        typename std::enable_if<std::is_same<Q, StyleString>::value, StyleString>::type T_to_string(Q x, unsigned int size) {
-            StyleString str = x.substr(0, size);
-            str += std::string(std::max(0, static_cast<int>(size - x.size())), ' ');
-            return str;
-        }
-
-        template<class Q = T>
-        typename std::enable_if < !std::is_same<Q, StyleString>::value, StyleString >::type T_to_string(Q x,
-                unsigned int size) {
-            std::stringstream ss;
-            ss << std::left << std::setw(size) << x;
-
-            return StyleString(ss.str());
+                return StyleString(align_to_width(ss.str(), size));
+            }
         }
 
       public:
@@ -221,42 +460,57 @@ namespace AwesomeViewer {
 
         ~MapCell() override = default;
 
+        const char *get_type() const override {
+            return "map";
+        }
+
+        void export_to(Exporter &exporter) const override {
+            for (const auto &p : _map) {
+                if constexpr (std::is_same<T, StyleString>::value) {
+                    exporter.entry(p.first, p.second.to_plain_string());
+                } else if constexpr (std::is_arithmetic<T>::value) {
+                    exporter.entry(p.first, static_cast<double>(p.second));
+                } else if constexpr (std::is_convertible<const T &, std::string_view>::value) {
+                    exporter.entry(p.first, std::string_view(p.second));
+                } else {
+                    std::stringstream ss;
+                    ss << p.second;
+                    exporter.entry(p.first, ss.str());
+                }
+            }
+        }
+
         void update() override {
             _data.clear();
 
             auto generated_map = _data_generator();
             unsigned int max_size = 0;
 
-            auto it = generated_map.begin();
-            for (unsigned int i = 0; i < _height; i++, it++) {
-                if (it == generated_map.cend()) {
-                    break;
-                }
-
-                if (it->first.size() > max_size) {
-                    max_size = it->first.size();
-                }
+            for (const auto &p : generated_map) {
+                max_size = std::max(max_size, static_cast<unsigned int>(display_width(p.first)));
             }
             max_size = std::min(max_size, _width - 3);
 
-            it = generated_map.begin();
-            for (unsigned int i = 0; i < _height; ++i) {
+            // One line per entry, even beyond the height to be scrolled to
+            auto it = generated_map.begin();
+            for (std::size_t i = 0; i < std::max<std::size_t>(_height, generated_map.size()); ++i) {
                 StyleString result;
 
                 if (it == generated_map.cend()) {
                     std::string str = std::string(max_size + 1, ' ') + "-" + std::string(_width - max_size - 2, ' ');
                     result.insert(Style(FontColor::Black, Font::Bold), str);
                 } else {
-                    std::stringstream ss_left;
-                    ss_left << std::right << std::setw(max_size) << it->first << " : ";
-                    result.insert(Style(FontColor::Black, Font::Bold), ss_left.str());
+                    std::string key = align_to_width(it->first, max_size, Align::Right);
+                    key += " : ";
+                    result.insert(Style(FontColor::Black, Font::Bold), std::move(key));
 
                     result += T_to_string(it->second, _width - 3 - max_size);
 
                     ++it;
                 }
-                _data.push_back(result.substr(0, _width));
+                _data.push_back(result.prefix_of_width(_width));
             }
+            _map = std::move(generated_map);
         }
     };
 }
@@ -0,0 +1,236 @@
+//
+// Created by terae on 19/10/26.
+//
+
+#ifndef AWESOME_VIEWER_DASHBOARDSTATE_H
+#define AWESOME_VIEWER_DASHBOARDSTATE_H
+
+#include "Style.hpp"
+#include "StyleString.hpp"
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <fcntl.h>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <utility>
+#include <vector>
+
+namespace AwesomeViewer {
+
+    struct SavedCell {
+        std::string name;
+        unsigned int x, y;
+        unsigned int width, height;
+        std::vector<StyleString> lines;
+    };
+
+    struct SavedPage {
+        std::string name;
+        std::vector<SavedCell> cells;
+    };
+
+    /**
+     * Placement and content of the cells of a dashboard, and its last frame, saved to paint the dashboard at once
+     * when it starts again. Compact binary format, in the byte order of the machine: it is a cache, not an export.
+     */
+    struct DashboardState {
+        static constexpr char magic[8] = {'A', 'V', 'S', 'T', 'A', 'T', 'E', '1'};
+
+        unsigned int width = 0;
+        unsigned int height = 0;
+        std::string frame;
+        std::vector<SavedPage> pages;
+
+      private:
+        class Writer {
+            std::string &_out;
+
+          public:
+            explicit Writer(std::string &out) : _out(out) {}
+
+            template<class T>
+            void number(T value) {
+                _out.append(reinterpret_cast<const char *>(&value), sizeof(value));
+            }
+
+            void text(std::string_view text) {
+                number(static_cast<std::uint32_t>(text.size()));
+                _out.append(text);
+            }
+        };
+
+        // Reads a file, `ok` becomes false at the first read beyond its end
+        class Reader {
+            const char *_position;
+            const char *_end;
+
+          public:
+            bool ok = true;
+
+            Reader(const char *begin, std::size_t size) : _position(begin), _end(begin + size) {}
+
+            template<class T>
+            T number() {
+                T value{};
+                if (static_cast<std::size_t>(_end - _position) < sizeof(T)) {
+                    ok = false;
+                    return value;
+                }
+                std::memcpy(&value, _position, sizeof(T));
+                _position += sizeof(T);
+                return value;
+            }
+
+            std::string text() {
+                const auto size = number<std::uint32_t>();
+                if (!ok || static_cast<std::size_t>(_end - _position) < size) {
+                    ok = false;
+                    return {};
+                }
+                std::string result(_position, size);
+                _position += size;
+                return result;
+            }
+
+            bool at_end() const {
+                return _position == _end;
+            }
+
+            // Upper bound of a count of elements, so that a corrupted count doesn't allocate gigabytes
+            std::uint32_t count() {
+                const auto count = number<std::uint32_t>();
+                if (count > static_cast<std::size_t>(_end - _position)) {
+                    ok = false;
+                    return 0;
+                }
+                return count;
+            }
+        };
+
+        static void write_line(Writer &writer, const StyleString &line) {
+            writer.number(static_cast<std::uint32_t>(line.segments().size()));
+            for (const auto &segment : line.segments()) {
+                const Style &style = segment.first;
+                writer.number(static_cast<std::uint8_t>(style.bg));
+                writer.number(static_cast<std::uint8_t>(style.fg));
+                writer.number(static_cast<std::uint16_t>(style.font));
+                writer.number(static_cast<std::int16_t>(style.bg_index));
+                writer.text(segment.second);
+            }
+        }
+
+        static StyleString read_line(Reader &reader) {
+            std::deque<std::pair<Style, std::string>> segments;
+            const auto count = reader.count();
+            for (std::uint32_t i = 0; i < count && reader.ok; ++i) {
+                Style style = Style::None();
+                style.bg = static_cast<Color>(reader.number<std::uint8_t>());
+                style.fg = static_cast<FontColor>(reader.number<std::uint8_t>());
+                style.font = static_cast<Font>(reader.number<std::uint16_t>());
+                style.bg_index = reader.number<std::int16_t>();
+                segments.emplace_back(style, reader.text());
+            }
+            return StyleString(std::move(segments));
+        }
+
+      public:
+        std::string serialize() const {
+            std::string out(magic, sizeof(magic));
+            Writer writer(out);
+            writer.number(static_cast<std::uint32_t>(width));
+            writer.number(static_cast<std::uint32_t>(height));
+            writer.text(frame);
+            writer.number(static_cast<std::uint32_t>(pages.size()));
+            for (const auto &page : pages) {
+                writer.text(page.name);
+                writer.number(static_cast<std::uint32_t>(page.cells.size()));
+                for (const auto &cell : page.cells) {
+                    writer.text(cell.name);
+                    for (auto value : {cell.x, cell.y, cell.width, cell.height}) {
+                        writer.number(static_cast<std::uint32_t>(value));
+                    }
+                    writer.number(static_cast<std::uint32_t>(cell.lines.size()));
+                    for (const auto &line : cell.lines) {
+                        write_line(writer, line);
+                    }
+                }
+            }
+            return out;
+        }
+
+        /**
+         * Read and decode the file `path`, not through a link. Return nothing if it doesn't exist or isn't a valid
+         * state, e.g. truncated or followed by other data.
+         */
+        static std::optional<DashboardState> load(const std::string &path) {
+            const int fd = open(path.c_str(), O_RDONLY | O_NOFOLLOW | O_CLOEXEC);
+            if (fd < 0) {
+                return std::nullopt;
+            }
+            struct stat status {};
+            if (fstat(fd, &status) != 0 || !S_ISREG(status.st_mode) ||
+                    static_cast<std::size_t>(status.st_size) < sizeof(magic)) {
+                close(fd);
+                return std::nullopt;
+            }
+            // Copied rather than mapped: a file truncated by another process while it is mapped would raise SIGBUS,
+            // whereas a short read is a size check
+            std::string data(static_cast<std::size_t>(status.st_size), '\0');
+            std::size_t size = 0;
+            while (size < data.size()) {
+                const auto n = read(fd, data.data() + size, data.size() - size);
+                if (n < 0 && errno == EINTR) {
+                    continue;
+                }
+                if (n <= 0) {
+                    break;
+                }
+                size += static_cast<std::size_t>(n);
+            }
+            close(fd);
+            if (size != data.size()) {
+                return std::nullopt;
+            }
+
+            DashboardState state;
+            const char *begin = data.data();
+            Reader reader(begin + sizeof(magic), size - sizeof(magic));
+            reader.ok = std::memcmp(begin, magic, sizeof(magic)) == 0;
+            if (reader.ok) {
+                state.width = reader.number<std::uint32_t>();
+                state.height = reader.number<std::uint32_t>();
+                state.frame = reader.text();
+                const auto page_count = reader.count();
+                for (std::uint32_t p = 0; p < page_count && reader.ok; ++p) {
+                    SavedPage page{reader.text(), {}};
+                    const auto cell_count = reader.count();
+                    for (std::uint32_t c = 0; c < cell_count && reader.ok; ++c) {
+                        SavedCell cell{reader.text(), 0, 0, 0, 0, {}};
+                        cell.x = reader.number<std::uint32_t>();
+                        cell.y = reader.number<std::uint32_t>();
+                        cell.width = reader.number<std::uint32_t>();
+                        cell.height = reader.number<std::uint32_t>();
+                        const auto line_count = reader.count();
+                        for (std::uint32_t l = 0; l < line_count && reader.ok; ++l) {
+                            cell.lines.push_back(read_line(reader));
+                        }
+                        page.cells.push_back(std::move(cell));
+                    }
+                    state.pages.push_back(std::move(page));
+                }
+            }
+            if (!reader.ok || !reader.at_end()) {
+                return std::nullopt;
+            }
+            return state;
+        }
+    };
+}
+
+#endif //AWESOME_VIEWER_DASHBOARDSTATE_H
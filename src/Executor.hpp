@@ -0,0 +1,371 @@
+//
+// Created by terae on 19/10/26.
+//
+
+#ifndef AWESOME_VIEWER_EXECUTOR_H
+#define AWESOME_VIEWER_EXECUTOR_H
+
+#include <chrono>
+#include <coroutine>
+#include <exception>
+#include <fcntl.h>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <poll.h>
+#include <queue>
+#include <stdexcept>
+#include <thread>
+#include <unistd.h>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace AwesomeViewer {
+
+    template<class T>
+    class AsyncGenerator;
+
+    /**
+     * Single-threaded event loop running the coroutine generators of a viewer.
+     * Coroutines are resumed on the executor thread only: the awaitables below must be awaited from a coroutine
+     * spawned on this executor.
+     */
+    class Executor {
+      public:
+        using Clock = std::chrono::steady_clock;
+
+      private:
+        struct Timer {
+            Clock::time_point deadline;
+            std::coroutine_handle<> handle;
+
+            friend bool operator>(const Timer &t1, const Timer &t2) {
+                return t1.deadline > t2.deadline;
+            }
+        };
+
+        struct Waiter {
+            int fd;
+            short events;
+            short *revents;
+            std::coroutine_handle<> handle;
+        };
+
+        std::mutex _mutex;
+        std::vector<std::coroutine_handle<>> _ready;
+        std::unordered_set<void *> _owned;
+        bool _stopping = false;
+
+        // Only touched from the executor thread
+        std::priority_queue<Timer, std::vector<Timer>, std::greater<>> _timers;
+        std::vector<Waiter> _waiters;
+
+        std::once_flag _started;
+        std::thread _thread;
+        int _wake[2] = {-1, -1};
+
+        void start() {
+            std::call_once(_started, [this]() {
+                if (pipe2(_wake, O_NONBLOCK | O_CLOEXEC) != 0) {
+                    throw std::runtime_error("Unable to create the executor wake-up pipe.");
+                }
+                _thread = std::thread([this]() {
+                    run();
+                });
+            });
+        }
+
+        void wake_up() {
+            if (_wake[1] != -1 && std::this_thread::get_id() != _thread.get_id()) {
+                char c = 0;
+                (void) !write(_wake[1], &c, 1);
+            }
+        }
+
+        void resume(std::coroutine_handle<> handle) {
+            handle.resume();
+            if (handle.done()) {
+                {
+                    std::lock_guard<std::mutex> lock(_mutex);
+                    _owned.erase(handle.address());
+                }
+                handle.destroy();
+            }
+        }
+
+        int next_timeout(bool has_ready) const {
+            if (has_ready) {
+                return 0;
+            }
+            if (_timers.empty()) {
+                return -1;
+            }
+            auto remaining = std::chrono::ceil<std::chrono::milliseconds>(_timers.top().deadline - Clock::now());
+            return static_cast<int>(std::max<std::chrono::milliseconds::rep>(0, remaining.count()));
+        }
+
+        void run() {
+            std::vector<std::coroutine_handle<>> batch;
+            std::vector<pollfd> fds;
+
+            for (;;) {
+                {
+                    std::lock_guard<std::mutex> lock(_mutex);
+                    if (_stopping) {
+                        return;
+                    }
+                    batch.swap(_ready);
+                }
+
+                for (auto handle : batch) {
+                    resume(handle);
+                }
+                batch.clear();
+
+                bool has_ready;
+                {
+                    std::lock_guard<std::mutex> lock(_mutex);
+                    has_ready = !_ready.empty();
+                }
+
+                fds.clear();
+                fds.push_back({_wake[0], POLLIN, 0});
+                for (const auto &waiter : _waiters) {
+                    fds.push_back({waiter.fd, waiter.events, 0});
+                }
+
+                if (poll(fds.data(), fds.size(), next_timeout(has_ready)) > 0 && fds[0].revents) {
+                    char buffer[64];
+                    while (read(_wake[0], buffer, sizeof(buffer)) > 0) {}
+                }
+
+                std::vector<std::coroutine_handle<>> woken;
+                for (std::size_t i = _waiters.size(); i-- > 0;) {
+                    if (fds[i + 1].revents) {
+                        *_waiters[i].revents = fds[i + 1].revents;
+                        woken.push_back(_waiters[i].handle);
+                        _waiters.erase(_waiters.begin() + static_cast<long>(i));
+                    }
+                }
+
+                const auto now = Clock::now();
+                while (!_timers.empty() && _timers.top().deadline <= now) {
+                    woken.push_back(_timers.top().handle);
+                    _timers.pop();
+                }
+
+                if (!woken.empty()) {
+                    std::lock_guard<std::mutex> lock(_mutex);
+                    _ready.insert(_ready.end(), woken.begin(), woken.end());
+                }
+            }
+        }
+
+      public:
+        struct ScheduleAwaiter {
+            Executor &executor;
+
+            constexpr bool await_ready() const noexcept {
+                return false;
+            }
+
+            void await_suspend(std::coroutine_handle<> handle) const {
+                executor.post(handle);
+            }
+
+            constexpr void await_resume() const noexcept {}
+        };
+
+        struct TimerAwaiter {
+            Executor &executor;
+            Clock::time_point deadline;
+
+            constexpr bool await_ready() const noexcept {
+                return false;
+            }
+
+            void await_suspend(std::coroutine_handle<> handle) const {
+                executor._timers.push({deadline, handle});
+            }
+
+            constexpr void await_resume() const noexcept {}
+        };
+
+        struct IoAwaiter {
+            Executor &executor;
+            int fd;
+            short events;
+            short revents = 0;
+
+            constexpr bool await_ready() const noexcept {
+                return false;
+            }
+
+            void await_suspend(std::coroutine_handle<> handle) {
+                executor._waiters.push_back({fd, events, &revents, handle});
+            }
+
+            // The `poll` events reported for the file descriptor
+            constexpr short await_resume() const noexcept {
+                return revents;
+            }
+        };
+
+        Executor() = default;
+        Executor(const Executor &) = delete;
+        Executor &operator=(const Executor &) = delete;
+
+        ~Executor() {
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+                _stopping = true;
+            }
+            if (_thread.joinable()) {
+                wake_up();
+                _thread.join();
+            }
+            for (void *address : _owned) {
+                std::coroutine_handle<>::from_address(address).destroy();
+            }
+            for (int fd : _wake) {
+                if (fd != -1) {
+                    close(fd);
+                }
+            }
+        }
+
+        void post(std::coroutine_handle<> handle) {
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+                _ready.push_back(handle);
+            }
+            wake_up();
+        }
+
+        ScheduleAwaiter schedule() {
+            return {*this};
+        }
+
+        TimerAwaiter sleep_for(Clock::duration duration) {
+            return {*this, Clock::now() + duration};
+        }
+
+        TimerAwaiter sleep_until(Clock::time_point deadline) {
+            return {*this, deadline};
+        }
+
+        IoAwaiter readable(int fd) {
+            return {*this, fd, POLLIN};
+        }
+
+        IoAwaiter writable(int fd) {
+            return {*this, fd, POLLOUT};
+        }
+
+        template<class T>
+        std::function<T()> spawn(AsyncGenerator<T> generator);
+    };
+
+    /**
+     * Last value yielded by a generator, read by the cell at each frame. The exception ending a generator is only
+     * thrown by the next read: the later ones return the last value, so that the other cells are still displayed.
+     */
+    template<class T>
+    class Latest {
+        mutable std::mutex _mutex;
+        T _value{};
+        std::exception_ptr _error;
+
+      public:
+        void publish(T value) {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _value = std::move(value);
+        }
+
+        void fail(std::exception_ptr error) {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _error = std::move(error);
+        }
+
+        T get() {
+            std::lock_guard<std::mutex> lock(_mutex);
+            if (_error) {
+                std::rethrow_exception(std::exchange(_error, nullptr));
+            }
+            return _value;
+        }
+    };
+
+    /**
+     * Coroutine producing the content of a cell: it can `co_await` the awaitables of its executor and `co_yield`
+     * new values, the next frame displays the last one.
+     */
+    template<class T>
+    class AsyncGenerator {
+      public:
+        struct promise_type {
+            std::shared_ptr<Latest<T>> latest = std::make_shared<Latest<T>>();
+            Executor *executor = nullptr;
+
+            AsyncGenerator get_return_object() {
+                return AsyncGenerator(std::coroutine_handle<promise_type>::from_promise(*this));
+            }
+
+            std::suspend_always initial_suspend() const noexcept {
+                return {};
+            }
+
+            std::suspend_always final_suspend() const noexcept {
+                return {};
+            }
+
+            Executor::ScheduleAwaiter yield_value(T value) {
+                latest->publish(std::move(value));
+                return executor->schedule();
+            }
+
+            void return_void() const noexcept {}
+
+            void unhandled_exception() {
+                latest->fail(std::current_exception());
+            }
+        };
+
+        AsyncGenerator(AsyncGenerator &&other) noexcept : _handle(std::exchange(other._handle, nullptr)) {}
+        AsyncGenerator(const AsyncGenerator &) = delete;
+
+        ~AsyncGenerator() {
+            if (_handle) {
+                _handle.destroy();
+            }
+        }
+
+      private:
+        std::coroutine_handle<promise_type> _handle;
+
+        explicit AsyncGenerator(std::coroutine_handle<promise_type> handle) : _handle(handle) {}
+
+        friend class Executor;
+    };
+
+    template<class T>
+    std::function<T()> Executor::spawn(AsyncGenerator<T> generator) {
+        auto handle = std::exchange(generator._handle, nullptr);
+        handle.promise().executor = this;
+        auto latest = handle.promise().latest;
+
+        start();
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _owned.insert(handle.address());
+        }
+        post(handle);
+
+        return [latest]() {
+            return latest->get();
+        };
+    }
+}
+
+#endif //AWESOME_VIEWER_EXECUTOR_H
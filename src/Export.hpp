@@ -0,0 +1,609 @@
+//
+// Created by terae on 19/10/26.
+//
+
+#ifndef AWESOME_VIEWER_EXPORT_H
+#define AWESOME_VIEWER_EXPORT_H
+
+#include "Format.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <fcntl.h>
+#include <memory>
+#include <mutex>
+#include <poll.h>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+namespace AwesomeViewer {
+
+    enum class ExportFormat {
+        Json,
+        LineProtocol,
+        KeyValue
+    };
+
+    /**
+     * Receives the logical content of the cells, without any style nor padding.
+     */
+    class Exporter {
+      public:
+        virtual ~Exporter() = default;
+
+        virtual void begin_cell(std::string_view page, std::string_view name, std::string_view type) = 0;
+        virtual void end_cell() = 0;
+
+        // Attribute of the cell
+        virtual void field(std::string_view key, double value) = 0;
+        virtual void field(std::string_view key, std::string_view value) = 0;
+
+        // Entry of a map
+        virtual void entry(std::string_view key, double value) = 0;
+        virtual void entry(std::string_view key, std::string_view value) = 0;
+
+        // Displayed line
+        virtual void line(std::string_view text) = 0;
+
+        virtual std::string finish() = 0;
+    };
+
+    /**
+     * {"cells":[{"page":"Main","name":"Timer","type":"string","lines":["5 s"]}, ...]}
+     */
+    class JsonExporter final : public Exporter {
+        std::string _document = "{\"cells\":[";
+        std::string _fields, _entries, _lines;
+        bool _first_cell = true;
+
+        static void append_string(std::string &out, std::string_view str) {
+            out += '"';
+            for (char c : str) {
+                switch (c) {
+                    case '"':
+                        out += "\\\"";
+                        break;
+                    case '\\':
+                        out += "\\\\";
+                        break;
+                    case '\n':
+                        out += "\\n";
+                        break;
+                    case '\t':
+                        out += "\\t";
+                        break;
+                    default:
+                        if (static_cast<unsigned char>(c) < 0x20) {
+                            static constexpr char hex[] = "0123456789abcdef";
+                            out += "\\u00";
+                            out += hex[(c >> 4) & 0xf];
+                            out += hex[c & 0xf];
+                        } else {
+                            out += c;
+                        }
+                }
+            }
+            out += '"';
+        }
+
+        static void append_number(std::string &out, double value) {
+            if (!std::isfinite(value)) {
+                out += "null";
+                return;
+            }
+            Chars chars;
+            chars.append_number(value);
+            out += chars.view();
+        }
+
+        static void append_key(std::string &out, std::string_view key) {
+            if (!out.empty()) {
+                out += ',';
+            }
+            append_string(out, key);
+            out += ':';
+        }
+
+      public:
+        void begin_cell(std::string_view page, std::string_view name, std::string_view type) override {
+            _fields.clear();
+            _entries.clear();
+            _lines.clear();
+            field("page", page);
+            field("name", name);
+            field("type", type);
+        }
+
+        void end_cell() override {
+            if (!_first_cell) {
+                _document += ',';
+            }
+            _first_cell = false;
+
+            _document += '{';
+            _document += _fields;
+            if (!_entries.empty()) {
+                _document += ",\"entries\":{" + _entries + '}';
+            }
+            if (!_lines.empty()) {
+                _document += ",\"lines\":[" + _lines + ']';
+            }
+            _document += '}';
+        }
+
+        void field(std::string_view key, double value) override {
+            append_key(_fields, key);
+            append_number(_fields, value);
+        }
+
+        void field(std::string_view key, std::string_view value) override {
+            append_key(_fields, key);
+            append_string(_fields, value);
+        }
+
+        void entry(std::string_view key, double value) override {
+            append_key(_entries, key);
+            append_number(_entries, value);
+        }
+
+        void entry(std::string_view key, std::string_view value) override {
+            append_key(_entries, key);
+            append_string(_entries, value);
+        }
+
+        void line(std::string_view text) override {
+            if (!_lines.empty()) {
+                _lines += ',';
+            }
+            append_string(_lines, text);
+        }
+
+        std::string finish() override {
+            return std::move(_document) + "]}\n";
+        }
+    };
+
+    /**
+     * InfluxDB line protocol, one line per cell:
+     * awesome_viewer,page=Main,cell=Progress\ bar,type=progress value=28,min=0,max=100 1700000000000000000
+     */
+    class LineProtocolExporter final : public Exporter {
+        std::string _document;
+        std::string _tags, _fields;
+        std::size_t _line = 0;
+        std::string _timestamp;
+
+        // Escape the characters separating the tags and the fields. A line break, which would end the line, is an
+        // escaped space.
+        static void append_escaped(std::string &out, std::string_view str) {
+            for (char c : str) {
+                if (c == '\n' || c == '\r') {
+                    out += "\\ ";
+                    continue;
+                }
+                if (c == ',' || c == '=' || c == ' ' || c == '\\') {
+                    out += '\\';
+                }
+                out += c;
+            }
+        }
+
+        void append_key(std::string_view prefix, std::string_view key) {
+            if (!_fields.empty()) {
+                _fields += ',';
+            }
+            append_escaped(_fields, prefix);
+            append_escaped(_fields, key);
+            _fields += '=';
+        }
+
+        void append_value(double value) {
+            Chars chars;
+            chars.append_number(std::isfinite(value) ? value : 0.0);
+            _fields += chars.view();
+        }
+
+        void append_value(std::string_view value) {
+            _fields += '"';
+            for (char c : value) {
+                if (c == '"' || c == '\\') {
+                    _fields += '\\';
+                }
+                _fields += (c == '\n' ? ' ' : c);
+            }
+            _fields += '"';
+        }
+
+      public:
+        LineProtocolExporter() {
+            Chars chars;
+            chars.append_number(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                    std::chrono::system_clock::now().time_since_epoch()).count());
+            _timestamp = chars.view();
+        }
+
+        void begin_cell(std::string_view page, std::string_view name, std::string_view type) override {
+            _tags = "awesome_viewer,page=";
+            append_escaped(_tags, page.empty() ? "-" : page);
+            _tags += ",cell=";
+            append_escaped(_tags, name.empty() ? "-" : name);
+            _tags += ",type=";
+            append_escaped(_tags, type);
+            _fields.clear();
+            _line = 0;
+        }
+
+        void end_cell() override {
+            // A point needs at least one field
+            if (!_fields.empty()) {
+                _document += _tags + ' ' + _fields + ' ' + _timestamp + '\n';
+            }
+        }
+
+        void field(std::string_view key, double value) override {
+            append_key("", key);
+            append_value(value);
+        }
+
+        void field(std::string_view key, std::string_view value) override {
+            append_key("", key);
+            append_value(value);
+        }
+
+        void entry(std::string_view key, double value) override {
+            append_key("entry.", key);
+            append_value(value);
+        }
+
+        void entry(std::string_view key, std::string_view value) override {
+            append_key("entry.", key);
+            append_value(value);
+        }
+
+        void line(std::string_view text) override {
+            Chars chars;
+            chars.append("line");
+            chars.append_number(_line++);
+            append_key("", chars.view());
+            append_value(text);
+        }
+
+        std::string finish() override {
+            return std::move(_document);
+        }
+    };
+
+    /**
+     * logfmt, one line per cell:
+     * cell=Main/Timer line0="5 s"
+     */
+    class KeyValueExporter final : public Exporter {
+      public:
+        struct Cell {
+            std::string name;
+            std::vector<std::pair<std::string, std::string>> values;
+        };
+
+      private:
+        std::vector<Cell> _cells;
+        std::size_t _line = 0;
+
+        static std::string quote(std::string_view str) {
+            const bool needs_quotes = str.empty() || str.find_first_of(" =\"\\\n") != std::string_view::npos;
+            if (!needs_quotes) {
+                return std::string(str);
+            }
+            std::string result = "\"";
+            for (char c : str) {
+                if (c == '"' || c == '\\') {
+                    result += '\\';
+                }
+                result += (c == '\n' ? ' ' : c);
+            }
+            return result + '"';
+        }
+
+        static std::string number(double value) {
+            Chars chars;
+            chars.append_number(value);
+            return std::string(chars.view());
+        }
+
+        void add(std::string_view key, std::string value) {
+            _cells.back().values.emplace_back(quote(key), std::move(value));
+        }
+
+      public:
+        void begin_cell(std::string_view page, std::string_view name, std::string_view) override {
+            _cells.push_back({quote(std::string(page) + '/' + std::string(name)), {}});
+            _line = 0;
+        }
+
+        void end_cell() override {}
+
+        void field(std::string_view key, double value) override {
+            add(key, number(value));
+        }
+
+        void field(std::string_view key, std::string_view value) override {
+            add(key, quote(value));
+        }
+
+        void entry(std::string_view key, double value) override {
+            add(key, number(value));
+        }
+
+        void entry(std::string_view key, std::string_view value) override {
+            add(key, quote(value));
+        }
+
+        void line(std::string_view text) override {
+            add("line" + std::to_string(_line++), quote(text));
+        }
+
+        const std::vector<Cell> &cells() const {
+            return _cells;
+        }
+
+        static std::string to_line(const std::string &name,
+                                   const std::vector<std::pair<std::string, std::string>> &values) {
+            std::string result = "cell=" + name;
+            for (const auto &value : values) {
+                result += ' ' + value.first + '=' + value.second;
+            }
+            return result + '\n';
+        }
+
+        std::string finish() override {
+            std::string document;
+            for (const auto &cell : _cells) {
+                document += to_line(cell.name, cell.values);
+            }
+            return document;
+        }
+    };
+
+    inline std::unique_ptr<Exporter> make_exporter(ExportFormat format) {
+        if (format == ExportFormat::LineProtocol) {
+            return std::make_unique<LineProtocolExporter>();
+        } else if (format == ExportFormat::KeyValue) {
+            return std::make_unique<KeyValueExporter>();
+        }
+        return std::make_unique<JsonExporter>();
+    }
+
+    /**
+     * Write `document` in a temporary file renamed to `path`, so that readers never see a partial export.
+     * The temporary file is created, never opened through a link: a stale one, e.g. left by a crash, is replaced.
+     */
+    inline void write_file_atomically(const std::string &path, const std::string &document) {
+        const std::string temporary = path + ".tmp";
+        constexpr int flags = O_WRONLY | O_CREAT | O_EXCL | O_NOFOLLOW | O_CLOEXEC;
+        int fd = open(temporary.c_str(), flags, 0666);
+        if (fd < 0 && errno == EEXIST && unlink(temporary.c_str()) == 0) {
+            fd = open(temporary.c_str(), flags, 0666);
+        }
+        if (fd < 0) {
+            throw std::runtime_error("Unable to open \"" + temporary + "\".");
+        }
+
+        std::string_view data = document;
+        while (!data.empty()) {
+            const auto n = write(fd, data.data(), data.size());
+            if (n < 0 && errno == EINTR) {
+                continue;
+            }
+            if (n <= 0) {
+                break;
+            }
+            data.remove_prefix(static_cast<std::size_t>(n));
+        }
+        if (close(fd) != 0 || !data.empty() || std::rename(temporary.c_str(), path.c_str()) != 0) {
+            unlink(temporary.c_str());
+            throw std::runtime_error("Unable to write \"" + path + "\".");
+        }
+    }
+
+    /**
+     * Local Unix socket sending an export to each client, then closing the connection.
+     * A connection requests an export, which is built by the rendering thread at the end of the next frame: the
+     * generators are never called for it. Without any frame during one second, the last export is sent, or the
+     * connection is closed if nothing has been published yet.
+     */
+    class ExportServer {
+        using Clock = std::chrono::steady_clock;
+
+        struct Client {
+            int fd;
+            Clock::time_point since;
+            // Being sent, from `sent`, once published
+            std::shared_ptr<const std::string> document;
+            std::size_t sent = 0;
+        };
+
+        // Delay before a client gets the last export instead of the next one
+        static constexpr auto _publish_timeout = std::chrono::seconds(1);
+        // A client not reading its export within this delay is dropped, so that it doesn't hold the others
+        static constexpr auto _send_timeout = std::chrono::seconds(1);
+
+        std::string _path;
+        int _socket = -1;
+        int _wake[2] = {-1, -1};
+        std::thread _thread;
+
+        std::mutex _mutex;
+        std::shared_ptr<const std::string> _document;
+        bool _fresh = false;
+        bool _stopping = false;
+        std::atomic<bool> _requested{false};
+
+        // Remove the socket left at `path` by a previous server, but never another kind of file
+        static void remove_socket(const std::string &path) {
+            struct stat status {};
+            if (lstat(path.c_str(), &status) == 0 && S_ISSOCK(status.st_mode)) {
+                unlink(path.c_str());
+            }
+        }
+
+        // Send what the socket accepts without blocking. Return false once the client is done with, sent or failed.
+        static bool send_some(Client &client) {
+            while (client.sent < client.document->size()) {
+                auto n = send(client.fd, client.document->data() + client.sent, client.document->size() - client.sent,
+                              MSG_NOSIGNAL);
+                if (n < 0 && errno == EINTR) {
+                    continue;
+                }
+                if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+                    return true;
+                }
+                if (n <= 0) {
+                    return false;
+                }
+                client.sent += static_cast<std::size_t>(n);
+            }
+            return false;
+        }
+
+        void run() {
+            std::vector<Client> clients;
+            std::vector<pollfd> fds;
+            for (;;) {
+                fds.assign({{_socket, POLLIN, 0}, {_wake[0], POLLIN, 0}});
+                for (const auto &client : clients) {
+                    if (client.document) {
+                        fds.push_back({client.fd, POLLOUT, 0});
+                    }
+                }
+                poll(fds.data(), fds.size(), clients.empty() ? -1 : 100);
+
+                if (fds[1].revents) {
+                    char buffer[64];
+                    while (read(_wake[0], buffer, sizeof(buffer)) > 0) {}
+                }
+                if (fds[0].revents & POLLIN) {
+                    int fd = accept4(_socket, nullptr, nullptr, SOCK_CLOEXEC | SOCK_NONBLOCK);
+                    if (fd != -1) {
+                        clients.push_back({fd, Clock::now(), nullptr, 0});
+                        _requested = true;
+                    }
+                }
+
+                std::shared_ptr<const std::string> document;
+                bool fresh;
+                {
+                    std::lock_guard<std::mutex> lock(_mutex);
+                    if (_stopping) {
+                        break;
+                    }
+                    document = _document;
+                    fresh = _fresh;
+                    _fresh = false;
+                }
+
+                const auto now = Clock::now();
+                for (std::size_t i = clients.size(); i-- > 0;) {
+                    auto &client = clients[i];
+                    const bool expired = now - client.since > _publish_timeout;
+                    if (!client.document && document && (fresh || expired)) {
+                        client.document = document;
+                        client.since = now;
+                    }
+                    if (client.document ? !send_some(client) || now - client.since > _send_timeout : expired) {
+                        close(client.fd);
+                        clients.erase(clients.begin() + static_cast<long>(i));
+                    }
+                }
+            }
+
+            for (const auto &client : clients) {
+                close(client.fd);
+            }
+        }
+
+        void wake_up() {
+            char c = 0;
+            (void) !write(_wake[1], &c, 1);
+        }
+
+      public:
+        /**
+         * A socket left at `path` by a previous server is replaced; any other file there is an error.
+         */
+        explicit ExportServer(std::string path) : _path(std::move(path)) {
+            sockaddr_un address{};
+            if (_path.size() >= sizeof(address.sun_path)) {
+                throw std::invalid_argument("Socket path too long.");
+            }
+            address.sun_family = AF_UNIX;
+            std::copy(_path.cbegin(), _path.cend(), address.sun_path);
+
+            // Nothing is created on the disk before the last call which may fail, but `listen`
+            if (pipe2(_wake, O_NONBLOCK | O_CLOEXEC) != 0) {
+                throw std::runtime_error("Unable to listen on \"" + _path + "\".");
+            }
+            _socket = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+            remove_socket(_path);
+            const bool bound = _socket != -1 && bind(_socket, reinterpret_cast<sockaddr *>(&address),
+                               sizeof(address)) == 0;
+            if (!bound || listen(_socket, 16) != 0) {
+                if (bound) {
+                    unlink(_path.c_str());
+                }
+                if (_socket != -1) {
+                    close(_socket);
+                }
+                close(_wake[0]);
+                close(_wake[1]);
+                throw std::runtime_error("Unable to listen on \"" + _path + "\".");
+            }
+
+            _thread = std::thread([this]() {
+                run();
+            });
+        }
+
+        ExportServer(const ExportServer &) = delete;
+        ExportServer &operator=(const ExportServer &) = delete;
+
+        ~ExportServer() {
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+                _stopping = true;
+            }
+            wake_up();
+            _thread.join();
+            close(_socket);
+            close(_wake[0]);
+            close(_wake[1]);
+            remove_socket(_path);
+        }
+
+        // Whether a client waits for an export
+        bool requested() const {
+            return _requested.load(std::memory_order_relaxed);
+        }
+
+        void publish(std::string document) {
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+                _document = std::make_shared<const std::string>(std::move(document));
+                _fresh = true;
+                _requested = false;
+            }
+            wake_up();
+        }
+    };
+}
+
+#endif //AWESOME_VIEWER_EXPORT_H
@@ -0,0 +1,247 @@
+//
+// Created by terae on 19/10/26.
+//
+
+#ifndef AWESOME_VIEWER_FORMAT_H
+#define AWESOME_VIEWER_FORMAT_H
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <span>
+#include <string_view>
+#include <type_traits>
+
+namespace AwesomeViewer {
+
+    enum class Align {
+        Left,
+        Right,
+        Center
+    };
+
+    /**
+     * Small stack buffer in which a value is formatted before being aligned in its field.
+     */
+    class Chars {
+        std::array<char, 64> _data{};
+        std::size_t _size = 0;
+
+      public:
+        constexpr std::string_view view() const {
+            return {_data.data(), _size};
+        }
+
+        constexpr void append(std::string_view str) {
+            auto n = std::min(str.size(), _data.size() - _size);
+            std::copy_n(str.data(), n, _data.data() + _size);
+            _size += n;
+        }
+
+        constexpr void append(char c) {
+            if (_size < _data.size()) {
+                _data[_size++] = c;
+            }
+        }
+
+        template<class T>
+        void append_number(T value) {
+            auto result = std::to_chars(_data.data() + _size, _data.data() + _data.size(), value);
+            if (result.ec == std::errc{}) {
+                _size = static_cast<std::size_t>(result.ptr - _data.data());
+            }
+        }
+
+        /**
+         * Return false if the number is too long for the buffer in `fmt`, e.g. 1e300 in fixed format: it is then
+         * written in scientific format, if that fits.
+         */
+        template<class T>
+        bool append_number(T value, std::chars_format fmt, int precision) {
+            auto result = std::to_chars(_data.data() + _size, _data.data() + _data.size(), value, fmt, precision);
+            if (result.ec == std::errc::value_too_large) {
+                append_number(value, std::chars_format::scientific);
+                return false;
+            }
+            _size = static_cast<std::size_t>(result.ptr - _data.data());
+            return true;
+        }
+
+        template<class T>
+        void append_number(T value, std::chars_format fmt) {
+            auto result = std::to_chars(_data.data() + _size, _data.data() + _data.size(), value, fmt);
+            if (result.ec == std::errc{}) {
+                _size = static_cast<std::size_t>(result.ptr - _data.data());
+            }
+        }
+    };
+
+    /**
+     * Write `text` in the whole `field`, padded with spaces, or truncated if it doesn't fit.
+     */
+    inline void format_aligned(std::span<char> field, std::string_view text, Align align = Align::Left) {
+        auto n = std::min(text.size(), field.size());
+        auto padding = field.size() - n;
+        auto before = (align == Align::Right ? padding : align == Align::Center ? padding / 2 : 0);
+
+        std::fill_n(field.begin(), before, ' ');
+        std::copy_n(text.begin(), n, field.begin() + static_cast<long>(before));
+        std::fill(field.begin() + static_cast<long>(before + n), field.end(), ' ');
+    }
+
+    template<class T>
+    constexpr bool is_formattable = std::is_arithmetic<T>::value ||
+                                    std::is_convertible<const T &, std::string_view>::value;
+
+    template<class T>
+    inline void format(std::span<char> field, const T &value, Align align = Align::Left) {
+        Chars chars;
+        if constexpr (std::is_same<T, char>::value) {
+            chars.append(value);
+        } else if constexpr (std::is_same<T, bool>::value) {
+            chars.append(value ? '1' : '0');
+        } else if constexpr (std::is_integral<T>::value) {
+            chars.append_number(value);
+        } else if constexpr (std::is_floating_point<T>::value) {
+            // Same output as a default `std::ostream`
+            chars.append_number(value, std::chars_format::general, 6);
+        } else {
+            format_aligned(field, std::string_view(value), align);
+            return;
+        }
+        format_aligned(field, chars.view(), align);
+    }
+
+    template<class T>
+    inline void format_fixed(std::span<char> field, T value, int decimals, Align align = Align::Right) {
+        Chars chars;
+        chars.append_number(static_cast<double>(value), std::chars_format::fixed, decimals);
+        format_aligned(field, chars.view(), align);
+    }
+
+    namespace detail {
+        // Up to 3 significant digits, followed by the prefix and the unit
+        inline void append_scaled(Chars &chars, double value, double base, const char *const *prefixes,
+                                  std::size_t count, std::string_view unit) {
+            if (!std::isfinite(value)) {
+                chars.append(std::isnan(value) ? "nan" : value < 0 ? "-inf" : "inf");
+                chars.append(unit);
+                return;
+            }
+
+            std::size_t i = 0;
+            double magnitude = std::abs(value);
+            while (i + 1 < count && magnitude >= 999.5) {
+                magnitude /= base;
+                value /= base;
+                ++i;
+            }
+
+            chars.append_number(value, std::chars_format::general, 3);
+            std::string_view prefix = prefixes[i];
+            if (!unit.empty()) {
+                chars.append(' ');
+            }
+            chars.append(prefix);
+            chars.append(unit);
+        }
+    }
+
+    /**
+     * 1234567 -> "1.23M", with a unit: "1.23 MB".
+     */
+    inline void format_si(std::span<char> field, double value, std::string_view unit = "", Align align = Align::Right) {
+        static constexpr const char *prefixes[] = {"", "k", "M", "G", "T", "P", "E"};
+        Chars chars;
+        detail::append_scaled(chars, value, 1000.0, prefixes, std::size(prefixes), unit);
+        format_aligned(field, chars.view(), align);
+    }
+
+    /**
+     * 1572864 -> "1.5Mi", with a unit: "1.5 MiB".
+     */
+    inline void format_binary(std::span<char> field, double value, std::string_view unit = "",
+                              Align align = Align::Right) {
+        static constexpr const char *prefixes[] = {"", "Ki", "Mi", "Gi", "Ti", "Pi", "Ei"};
+        Chars chars;
+        detail::append_scaled(chars, value, 1024.0, prefixes, std::size(prefixes), unit);
+        format_aligned(field, chars.view(), align);
+    }
+
+    /**
+     * Events per second: 1234.5 -> "1.23k/s".
+     */
+    inline void format_rate(std::span<char> field, double per_second, std::string_view unit = "",
+                            Align align = Align::Right) {
+        static constexpr const char *prefixes[] = {"", "k", "M", "G", "T", "P", "E"};
+        Chars chars;
+        detail::append_scaled(chars, per_second, 1000.0, prefixes, std::size(prefixes), unit);
+        chars.append("/s");
+        format_aligned(field, chars.view(), align);
+    }
+
+    /**
+     * `percent` is in [0, 100]: 42.42 -> "42%", or "42.4%" with 1 decimal.
+     */
+    inline void format_percent(std::span<char> field, double percent, int decimals = 0, Align align = Align::Right) {
+        Chars chars;
+        chars.append_number(percent, std::chars_format::fixed, decimals);
+        chars.append('%');
+        format_aligned(field, chars.view(), align);
+    }
+
+    /**
+     * 1.5e-5 s -> "15us", 90 s -> "1m30s", 7200 s -> "2h00m".
+     */
+    template<class Rep, class Period>
+    inline void format_duration(std::span<char> field, std::chrono::duration<Rep, Period> duration,
+                                Align align = Align::Right) {
+        const double ns = std::chrono::duration<double, std::nano>(duration).count();
+        Chars chars;
+        if (!std::isfinite(ns) || std::abs(ns) < 60e9) {
+            static constexpr const char *units[] = {"ns", "us", "ms", "s"};
+            double value = ns;
+            std::size_t i = 0;
+            while (i + 1 < std::size(units) && std::abs(value) >= 999.5) {
+                value /= 1000.0;
+                ++i;
+            }
+            chars.append_number(value, std::chars_format::general, 3);
+            chars.append(units[i]);
+        } else {
+            auto append_two = [&chars](long long n) {
+                if (n < 10) {
+                    chars.append('0');
+                }
+                chars.append_number(n);
+            };
+
+            auto s = static_cast<long long>(std::abs(ns) / 1e9);
+            if (ns < 0) {
+                chars.append('-');
+            }
+            if (s < 3600) {
+                chars.append_number(s / 60);
+                chars.append('m');
+                append_two(s % 60);
+                chars.append('s');
+            } else if (s < 86400) {
+                chars.append_number(s / 3600);
+                chars.append('h');
+                append_two(s % 3600 / 60);
+                chars.append('m');
+            } else {
+                chars.append_number(s / 86400);
+                chars.append('d');
+                append_two(s % 86400 / 3600);
+                chars.append('h');
+            }
+        }
+        format_aligned(field, chars.view(), align);
+    }
+}
+
+#endif //AWESOME_VIEWER_FORMAT_H
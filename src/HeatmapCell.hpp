@@ -0,0 +1,217 @@
+//
+// Created by terae on 19/10/26.
+//
+
+#ifndef AWESOME_VIEWER_HEATMAPCELL_H
+#define AWESOME_VIEWER_HEATMAPCELL_H
+
+#include "Cell.hpp"
+#include "Style.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace AwesomeViewer {
+
+    /**
+     * Dense row-major matrix of floats, not owned. `stride` is the distance between two rows, in floats.
+     */
+    struct MatrixView {
+        const float *data = nullptr;
+        std::size_t rows = 0;
+        std::size_t cols = 0;
+        std::size_t stride = 0;
+
+        MatrixView() = default;
+
+        MatrixView(const float *data, std::size_t rows, std::size_t cols, std::size_t stride = 0) :
+            data(data), rows(rows), cols(cols), stride(stride == 0 ? cols : stride) {}
+    };
+
+    /**
+     * Index of the level of each value in [0, levels - 1], `lowest` being the level 0 and `lowest + 1 / scale` the
+     * level 1. Written without branches so that the compiler vectorises it; NaN values are at level 0.
+     */
+    inline void quantize(const float *values, std::uint8_t *levels, std::size_t count, float lowest, float scale,
+                         unsigned int level_count) {
+        const float highest_level = static_cast<float>(level_count - 1);
+        for (std::size_t i = 0; i < count; ++i) {
+            const float level = std::max(0.0f, std::min((values[i] - lowest) * scale, highest_level));
+            levels[i] = static_cast<std::uint8_t>(level);
+        }
+    }
+
+    class HeatmapCell final : public AbstractCell {
+      public:
+        enum class Palette {
+            // 5 background colours, from blue to red
+            Basic,
+            // 21 colours of the 256-colour palette, from blue to red
+            Extended,
+            // Extended if the terminal advertises 256 colours, Basic otherwise
+            Auto
+        };
+
+      private:
+        std::function<MatrixView()> _matrix_generator;
+        std::vector<Style> _palette;
+        bool _fixed_range = false;
+        float _lowest = 0.0f;
+        float _highest = 1.0f;
+
+        // Reused by each frame
+        std::vector<float> _row_sums;
+        std::vector<float> _cells;
+        std::vector<std::uint8_t> _levels;
+
+        static bool supports_256_colors() {
+            const char *colorterm = std::getenv("COLORTERM");
+            const char *term = std::getenv("TERM");
+            return (colorterm != nullptr && *colorterm != '\0') ||
+                   (term != nullptr && std::string_view(term).find("256") != std::string_view::npos);
+        }
+
+        static std::vector<Style> make_palette(Palette palette) {
+            if (palette == Palette::Auto) {
+                palette = supports_256_colors() ? Palette::Extended : Palette::Basic;
+            }
+
+            std::vector<Style> result;
+            if (palette == Palette::Basic) {
+                for (auto color : {Color::Blue, Color::Cyan, Color::Green, Color::Yellow, Color::Red}) {
+                    result.emplace_back(Font::Default, color);
+                }
+                return result;
+            }
+
+            // Blue -> cyan -> green -> yellow -> red in the 6x6x6 colour cube
+            const int steps[4][3] = {{0, 1, 0}, {0, 0, -1}, {1, 0, 0}, {0, -1, 0}};
+            int rgb[3] = {0, 0, 5};
+            auto push = [&result, &rgb]() {
+                const auto index = static_cast<unsigned char>(16 + 36 * rgb[0] + 6 * rgb[1] + rgb[2]);
+                result.push_back(Style::Default().with_background({index}));
+            };
+            push();
+            for (const auto &step : steps) {
+                for (int i = 0; i < 5; ++i) {
+                    for (int c = 0; c < 3; ++c) {
+                        rgb[c] += step[c];
+                    }
+                    push();
+                }
+            }
+            return result;
+        }
+
+        // Average of the values covered by each character
+        void downsample(const MatrixView &matrix) {
+            _cells.assign(static_cast<std::size_t>(_width) * _height, 0.0f);
+            if (matrix.data == nullptr || matrix.rows == 0 || matrix.cols == 0) {
+                return;
+            }
+
+            _row_sums.resize(matrix.cols);
+            for (std::size_t r = 0; r < _height; ++r) {
+                const std::size_t first_row = r * matrix.rows / _height;
+                const std::size_t last_row = std::max(first_row + 1, (r + 1) * matrix.rows / _height);
+
+                // Element-wise sums of the rows, vectorised
+                std::fill(_row_sums.begin(), _row_sums.end(), 0.0f);
+                for (std::size_t y = first_row; y < last_row; ++y) {
+                    const float *row = matrix.data + y * matrix.stride;
+                    float *sums = _row_sums.data();
+                    for (std::size_t x = 0; x < matrix.cols; ++x) {
+                        sums[x] += row[x];
+                    }
+                }
+
+                for (std::size_t c = 0; c < _width; ++c) {
+                    const std::size_t first_col = c * matrix.cols / _width;
+                    const std::size_t last_col = std::max(first_col + 1, (c + 1) * matrix.cols / _width);
+                    float sum = 0.0f;
+                    for (std::size_t x = first_col; x < last_col; ++x) {
+                        sum += _row_sums[x];
+                    }
+                    _cells[r * _width + c] = sum / static_cast<float>((last_row - first_row) * (last_col - first_col));
+                }
+            }
+        }
+
+      public:
+        /**
+         * The matrix is downsampled to one value per character, by averaging the values it covers, and coloured
+         * according to the range of the values, or to the range given to `set_range`.
+         * A matrix smaller than the cell is stretched.
+         */
+        HeatmapCell(unsigned int width, unsigned int height, std::function<MatrixView()> matrix_generator,
+                    Palette palette = Palette::Auto) :
+            AbstractCell(width, height), _matrix_generator(std::move(matrix_generator)),
+            _palette(make_palette(palette)) {}
+
+        ~HeatmapCell() override = default;
+
+        const char *get_type() const override {
+            return "heatmap";
+        }
+
+        void set_range(float lowest, float highest) {
+            _fixed_range = true;
+            _lowest = lowest;
+            _highest = highest;
+        }
+
+        void export_to(Exporter &exporter) const override {
+            exporter.field("min", _lowest);
+            exporter.field("max", _highest);
+        }
+
+        void update() override {
+            downsample(_matrix_generator());
+
+            if (!_fixed_range) {
+                // The infinite values are at the first or last level, and don't stretch the scale
+                _lowest = std::numeric_limits<float>::max();
+                _highest = std::numeric_limits<float>::lowest();
+                for (float value : _cells) {
+                    if (std::isfinite(value)) {
+                        _lowest = std::min(_lowest, value);
+                        _highest = std::max(_highest, value);
+                    }
+                }
+                if (_lowest > _highest) {
+                    _lowest = _highest = 0.0f;
+                }
+            }
+            const auto levels = static_cast<unsigned int>(_palette.size());
+            // In double, so that the range of two finite floats doesn't overflow
+            const double range = static_cast<double>(_highest) - static_cast<double>(_lowest);
+            const float scale = (range > 0.0 && std::isfinite(range) ? static_cast<float>(levels / range) : 0.0f);
+            _levels.resize(_cells.size());
+            quantize(_cells.data(), _levels.data(), _cells.size(), _lowest, scale, levels);
+
+            // One span per run of characters of the same colour
+            _data.clear();
+            for (std::size_t r = 0; r < _height; ++r) {
+                StyleString line;
+                const std::uint8_t *row = _levels.data() + r * _width;
+                std::size_t begin = 0;
+                for (std::size_t c = 1; c <= _width; ++c) {
+                    if (c == _width || row[c] != row[begin]) {
+                        line.insert(_palette[row[begin]], std::string(c - begin, ' '));
+                        begin = c;
+                    }
+                }
+                _data.push_back(std::move(line));
+            }
+        }
+    };
+}
+
+#endif //AWESOME_VIEWER_HEATMAPCELL_H
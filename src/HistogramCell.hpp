@@ -0,0 +1,276 @@
+//
+// Created by terae on 19/10/26.
+//
+
+#ifndef AWESOME_VIEWER_HISTOGRAMCELL_H
+#define AWESOME_VIEWER_HISTOGRAMCELL_H
+
+#include "Cell.hpp"
+#include "Format.hpp"
+#include "utils.hpp"
+
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace AwesomeViewer {
+
+    /**
+     * HDR-style histogram of latencies in nanoseconds: each power of two is split into 64 linear sub-buckets (less
+     * than 1.6% of error), values over 2^40 ns (~18 min) are saturated.
+     * `record` is wait-free: each thread increments relaxed atomics of its own shard, the shards are merged by
+     * `snapshot` at frame time.
+     */
+    class LatencyHistogram {
+      public:
+        static constexpr unsigned int precision_bits = 7;
+        static constexpr unsigned int max_bits = 40;
+        static constexpr std::size_t sub_buckets = std::size_t(1) << (precision_bits - 1);
+        static constexpr std::size_t bucket_count = (max_bits - precision_bits + 2) * sub_buckets;
+        static constexpr std::size_t shard_count = 8;
+        static constexpr std::uint64_t max_value = (std::uint64_t(1) << max_bits) - 1;
+
+        class Snapshot {
+            std::vector<std::uint64_t> _counts = std::vector<std::uint64_t>(bucket_count, 0);
+            std::uint64_t _total = 0;
+
+            friend class LatencyHistogram;
+
+          public:
+            std::uint64_t total() const {
+                return _total;
+            }
+
+            std::uint64_t count(std::size_t bucket) const {
+                return _counts[bucket];
+            }
+
+            // Highest value equivalent to the `percent` percentile, 0 if empty
+            std::uint64_t percentile(double percent) const {
+                if (_total == 0) {
+                    return 0;
+                }
+                auto rank = static_cast<std::uint64_t>(std::ceil(percent / 100.0 * static_cast<double>(_total)));
+                rank = std::max<std::uint64_t>(1, std::min(rank, _total));
+
+                std::uint64_t cumulated = 0;
+                for (std::size_t i = 0; i < bucket_count; ++i) {
+                    cumulated += _counts[i];
+                    if (cumulated >= rank) {
+                        return highest_of(i);
+                    }
+                }
+                return max_value;
+            }
+
+            // `this - previous`, bucket per bucket
+            void subtract(const Snapshot &previous) {
+                for (std::size_t i = 0; i < bucket_count; ++i) {
+                    _counts[i] -= previous._counts[i];
+                }
+                _total -= previous._total;
+            }
+        };
+
+      private:
+        struct alignas(64) Shard {
+            std::array<std::atomic<std::uint64_t>, bucket_count> buckets{};
+        };
+
+        std::unique_ptr<Shard[]> _shards = std::make_unique<Shard[]>(shard_count);
+
+        static std::size_t shard_index() {
+            static std::atomic<std::size_t> next{0};
+            thread_local std::size_t index = next.fetch_add(1, std::memory_order_relaxed) % shard_count;
+            return index;
+        }
+
+      public:
+        static constexpr std::size_t bucket_of(std::uint64_t value) {
+            value = std::min(value, max_value);
+            if (value < (std::uint64_t(1) << precision_bits)) {
+                return value;
+            }
+            auto msb = static_cast<unsigned int>(63 - std::countl_zero(value));
+            auto shift = msb - precision_bits + 1;
+            return (std::size_t(shift + 1) << (precision_bits - 1)) | ((value >> shift) & (sub_buckets - 1));
+        }
+
+        static constexpr std::uint64_t lowest_of(std::size_t bucket) {
+            if (bucket < (std::size_t(1) << precision_bits)) {
+                return bucket;
+            }
+            auto shift = (bucket >> (precision_bits - 1)) - 1;
+            return ((bucket & (sub_buckets - 1)) | sub_buckets) << shift;
+        }
+
+        static constexpr std::uint64_t highest_of(std::size_t bucket) {
+            if (bucket < (std::size_t(1) << precision_bits)) {
+                return bucket;
+            }
+            auto shift = (bucket >> (precision_bits - 1)) - 1;
+            return ((((bucket & (sub_buckets - 1)) | sub_buckets) + 1) << shift) - 1;
+        }
+
+        inline void record(std::uint64_t nanoseconds) {
+            _shards[shard_index()].buckets[bucket_of(nanoseconds)].fetch_add(1, std::memory_order_relaxed);
+        }
+
+        template<class Rep, class Period>
+        inline void record(std::chrono::duration<Rep, Period> duration) {
+            auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count();
+            record(static_cast<std::uint64_t>(std::max<decltype(ns)>(0, ns)));
+        }
+
+        // Merge all the shards in `result`, reusing its storage
+        void snapshot(Snapshot &result) const {
+            result._total = 0;
+            for (std::size_t i = 0; i < bucket_count; ++i) {
+                std::uint64_t count = 0;
+                for (std::size_t s = 0; s < shard_count; ++s) {
+                    count += _shards[s].buckets[i].load(std::memory_order_relaxed);
+                }
+                result._counts[i] = count;
+                result._total += count;
+            }
+        }
+    };
+
+    class HistogramCell final : public AbstractCell {
+        static constexpr std::array<std::pair<double, const char *>, 4> _percentiles = {{
+                {50.0, "p50"}, {90.0, "p90"}, {99.0, "p99"}, {99.9, "p99.9"}
+            }
+        };
+
+        const LatencyHistogram &_histogram;
+        bool _interval;
+        LatencyHistogram::Snapshot _current;
+        LatencyHistogram::Snapshot _cumulative;
+        LatencyHistogram::Snapshot _previous;
+        std::vector<std::uint64_t> _columns;
+
+        StyleString percentile_line(std::size_t first, std::size_t last) const {
+            StyleString result;
+            unsigned int remaining = _width;
+            // The last percentiles are dropped rather than given less than 2 columns, for a label and a value
+            last = first + std::min<std::size_t>(last - first, std::max(1u, _width / 2));
+            const unsigned int field = _width / static_cast<unsigned int>(last - first);
+
+            for (std::size_t i = first; i < last && remaining > 0; ++i) {
+                const unsigned int width = std::min(remaining, (i + 1 == last ? remaining : field));
+                if (width < 2) {
+                    result.insert(Style::Default(), std::string(width, ' '));
+                    break;
+                }
+                const std::string_view label = _percentiles[i].second;
+                const unsigned int label_width = std::min<unsigned int>(width, static_cast<unsigned int>(
+                                                     (last - first == 1 ? 5 : label.size()) + 1));
+
+                std::string str_label(label_width, ' ');
+                format_aligned(std::span<char>(str_label).first(label_width - 1), label, Align::Right);
+                result.insert(Style(FontColor::Black, Font::Bold), std::move(str_label));
+
+                std::string value(width - label_width, ' ');
+                // Keep a space between two percentiles of the same line
+                auto field_value = std::span<char>(value).first(value.size() - (i + 1 < last && !value.empty()));
+                if (_current.total() == 0) {
+                    format_aligned(field_value, "-", Align::Left);
+                } else {
+                    format_duration(field_value, std::chrono::nanoseconds(_current.percentile(_percentiles[i].first)),
+                                    Align::Left);
+                }
+                result.insert(Style::Default(), std::move(value));
+                remaining -= width;
+            }
+            return result;
+        }
+
+        StyleString distribution_line() {
+            std::size_t first = LatencyHistogram::bucket_count, last = 0;
+            for (std::size_t i = 0; i < LatencyHistogram::bucket_count; ++i) {
+                if (_current.count(i)) {
+                    first = std::min(first, i);
+                    last = i;
+                }
+            }
+
+            std::string bar;
+            if (first > last) {
+                bar = std::string(_width, ' ');
+            } else {
+                _columns.assign(_width, 0);
+                const std::size_t span = last - first + 1;
+                for (std::size_t i = first; i <= last; ++i) {
+                    _columns[(i - first) * _width / span] += _current.count(i);
+                }
+
+                const auto highest = *std::max_element(_columns.cbegin(), _columns.cend());
+                for (auto count : _columns) {
+                    auto eighths = static_cast<unsigned int>((count * 8 + highest - 1) / highest);
+                    bar += vertical_block(eighths);
+                }
+            }
+            return {Style(FontColor::Cyan), std::move(bar)};
+        }
+
+      public:
+        /**
+         * With `interval`, each frame only shows the latencies recorded since the previous one.
+         */
+        HistogramCell(unsigned int width, unsigned int height, const LatencyHistogram &histogram,
+                      bool interval = false) :
+            AbstractCell(width, height), _histogram(histogram), _interval(interval) {}
+
+        ~HistogramCell() override = default;
+
+        const char *get_type() const override {
+            return "histogram";
+        }
+
+        void export_to(Exporter &exporter) const override {
+            exporter.field("count", static_cast<double>(_current.total()));
+            for (const auto &percentile : _percentiles) {
+                exporter.field(percentile.second, static_cast<double>(_current.percentile(percentile.first)));
+            }
+        }
+
+        void update() override {
+            _data.clear();
+
+            if (_interval) {
+                _histogram.snapshot(_cumulative);
+                _current = _cumulative;
+                _current.subtract(_previous);
+                std::swap(_previous, _cumulative);
+            } else {
+                _histogram.snapshot(_current);
+            }
+
+            const unsigned int text_lines = (_height > 1 ? _height - 1 : _height);
+            if (text_lines >= _percentiles.size()) {
+                for (std::size_t i = 0; i < _percentiles.size(); ++i) {
+                    _data.push_back(percentile_line(i, i + 1));
+                }
+            } else if (text_lines >= 2) {
+                _data.push_back(percentile_line(0, 2));
+                _data.push_back(percentile_line(2, 4));
+            } else {
+                _data.push_back(percentile_line(0, _percentiles.size()));
+            }
+
+            while (_data.size() + 1 < _height) {
+                _data.emplace_back(Style::Default(), std::string(_width, ' '));
+            }
+            if (_height > 1) {
+                _data.push_back(distribution_line());
+            }
+        }
+    };
+}
+
+#endif //AWESOME_VIEWER_HISTOGRAMCELL_H
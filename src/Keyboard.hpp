@@ -0,0 +1,351 @@
+//
+// Created by terae on 19/10/26.
+//
+
+#ifndef AWESOME_VIEWER_KEYBOARD_H
+#define AWESOME_VIEWER_KEYBOARD_H
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <iterator>
+#include <mutex>
+#include <poll.h>
+#include <string>
+#include <termios.h>
+#include <unistd.h>
+
+namespace AwesomeViewer {
+
+    // Keys without a character, returned by `Keyboard::read_key` after the characters
+    enum Key : int {
+        NoKey = -1,
+        Up = 0x100,
+        Down,
+        Left,
+        Right,
+        PageUp,
+        PageDown,
+        Home,
+        End,
+        BackTab
+    };
+
+    namespace detail {
+        // Terminal state restored by the signal handlers: only one keyboard is in raw mode at a time
+        inline termios saved_termios{};
+        inline termios raw_termios{};
+        inline volatile std::sig_atomic_t raw_mode = 0;
+        inline volatile std::sig_atomic_t keyboard_enabled = 0;
+
+        // Set while a terminal displays the alternate screen, which the handlers leave with the cursor shown
+        inline volatile std::sig_atomic_t alternate_screen = 0;
+        inline volatile std::sig_atomic_t left_alternate_screen = 0;
+        // Set when a handler entered the alternate screen again: its content was lost
+        inline volatile std::sig_atomic_t alternate_screen_cleared = 0;
+        constexpr char leave_alternate_screen_sequence[] = "\e[0m\e[?25h\e[?1049l";
+        constexpr char enter_alternate_screen_sequence[] = "\e[?1049h\e[?25l";
+
+        // The signals which terminate the process, then the job control ones
+        constexpr int keyboard_signals[] = {SIGINT, SIGTERM, SIGHUP, SIGQUIT, SIGTSTP, SIGCONT};
+        inline struct sigaction previous_actions[std::size(keyboard_signals)] {};
+        // Number of keyboards and terminals needing the handlers
+        inline std::mutex handlers_mutex;
+        inline int handlers_users = 0;
+
+        template<std::size_t N>
+        void write_sequence(const char (&sequence)[N]) {
+            std::size_t written = 0;
+            while (written < N - 1) {
+                const auto n = write(STDOUT_FILENO, sequence + written, N - 1 - written);
+                if (n < 0 && errno == EINTR) {
+                    continue;
+                }
+                if (n <= 0) {
+                    return;
+                }
+                written += static_cast<std::size_t>(n);
+            }
+        }
+
+        inline void restore_terminal() {
+            if (raw_mode) {
+                tcsetattr(STDIN_FILENO, TCSAFLUSH, &saved_termios);
+                raw_mode = 0;
+            }
+        }
+
+        // Back in raw mode, unless the process was resumed in the background, where it would be stopped by SIGTTOU
+        inline void enter_raw_mode() {
+            if (keyboard_enabled && !raw_mode && tcgetpgrp(STDIN_FILENO) == getpgrp()) {
+                tcsetattr(STDIN_FILENO, TCSAFLUSH, &raw_termios);
+                raw_mode = 1;
+            }
+        }
+
+        // The terminal as before the process, for the shell: cooked mode, main screen and visible cursor
+        inline void suspend_terminal() {
+            restore_terminal();
+            if (alternate_screen && !left_alternate_screen) {
+                write_sequence(leave_alternate_screen_sequence);
+                left_alternate_screen = 1;
+            }
+        }
+
+        // Reverts `suspend_terminal` once the process is in the foreground again
+        inline void resume_terminal() {
+            enter_raw_mode();
+            if (alternate_screen && left_alternate_screen && tcgetpgrp(STDOUT_FILENO) == getpgrp()) {
+                write_sequence(enter_alternate_screen_sequence);
+                left_alternate_screen = 0;
+                alternate_screen_cleared = 1;
+            }
+        }
+
+        // Call the handler installed before the keyboard's, return false if it is the default action
+        inline bool chain_signal(int signal, siginfo_t *info, void *context) {
+            for (std::size_t i = 0; i < std::size(keyboard_signals); ++i) {
+                if (keyboard_signals[i] != signal) {
+                    continue;
+                }
+                const struct sigaction &previous = previous_actions[i];
+                if (previous.sa_flags & SA_SIGINFO) {
+                    previous.sa_sigaction(signal, info, context);
+                    return true;
+                }
+                if (previous.sa_handler == SIG_DFL) {
+                    return false;
+                }
+                if (previous.sa_handler != SIG_IGN) {
+                    previous.sa_handler(signal);
+                }
+                return true;
+            }
+            return false;
+        }
+
+        // Perform the default action of `signal` from its handler, and reinstall the handler if the process survives
+        inline void raise_default(int signal) {
+            struct sigaction current {};
+            struct sigaction default_action {};
+            default_action.sa_handler = SIG_DFL;
+            sigemptyset(&default_action.sa_mask);
+            sigaction(signal, &default_action, &current);
+
+            sigset_t unblocked;
+            sigemptyset(&unblocked);
+            sigaddset(&unblocked, signal);
+            sigprocmask(SIG_UNBLOCK, &unblocked, nullptr);
+            std::raise(signal);
+            sigaction(signal, &current, nullptr);
+        }
+
+        inline void handle_signal(int signal, siginfo_t *info, void *context) {
+            const int saved_errno = errno;
+            if (signal != SIGCONT) {
+                suspend_terminal();
+                if (!chain_signal(signal, info, context)) {
+                    // Terminated, or stopped by SIGTSTP until SIGCONT
+                    raise_default(signal);
+                }
+            } else {
+                chain_signal(signal, info, context);
+            }
+            // The process goes on: after SIGCONT, or if a previous handler didn't end it
+            resume_terminal();
+            errno = saved_errno;
+        }
+
+        // Install `handle_signal` for the first user, the previous handlers are restored after the last one
+        inline void install_signal_handlers() {
+            std::lock_guard<std::mutex> lock(handlers_mutex);
+            if (handlers_users++ > 0) {
+                return;
+            }
+            struct sigaction action {};
+            action.sa_sigaction = handle_signal;
+            action.sa_flags = SA_SIGINFO;
+            sigemptyset(&action.sa_mask);
+            for (std::size_t i = 0; i < std::size(keyboard_signals); ++i) {
+                const int signal = keyboard_signals[i];
+                sigaction(signal, nullptr, &previous_actions[i]);
+                // An ignored signal, e.g. SIGHUP under nohup, stays ignored
+                if (previous_actions[i].sa_handler != SIG_IGN) {
+                    sigaction(signal, &action, nullptr);
+                }
+            }
+        }
+
+        inline void uninstall_signal_handlers() {
+            std::lock_guard<std::mutex> lock(handlers_mutex);
+            if (--handlers_users > 0) {
+                return;
+            }
+            for (std::size_t i = 0; i < std::size(keyboard_signals); ++i) {
+                sigaction(keyboard_signals[i], &previous_actions[i], nullptr);
+            }
+        }
+    }
+
+    /**
+     * Non-blocking keyboard input: the terminal is in raw mode, without echo nor line buffering, while the keyboard
+     * exists. Its previous state is restored by the destructor, by the signals which terminate the process, and while
+     * the process is suspended. Ctrl-C still sends SIGINT, and the handlers installed before the keyboard still run.
+     */
+    class Keyboard {
+        bool _enabled = false;
+        // Bytes read but not decoded yet, e.g. the beginning of an escape sequence
+        std::string _pending;
+        // An escape sequence may arrive in several reads: a lone escape is the Escape key only after this delay
+        static constexpr std::chrono::milliseconds _escape_delay{30};
+        std::chrono::steady_clock::time_point _incomplete_since{};
+
+        // Decode the first key of `_pending`, NoKey if its escape sequence is incomplete
+        int decode() {
+            const auto c = static_cast<unsigned char>(_pending[0]);
+            if (c != '\e') {
+                _pending.erase(0, 1);
+                return c;
+            }
+            if (_pending.size() == 1) {
+                return NoKey;
+            }
+            if (_pending[1] != '[' && _pending[1] != 'O') {
+                _pending.erase(0, 1);
+                return c;
+            }
+            std::size_t end = 2;
+            while (end < _pending.size() && (_pending[end] < 0x40 || _pending[end] > 0x7e)) {
+                ++end;
+            }
+            if (end == _pending.size()) {
+                return NoKey;
+            }
+
+            const std::string sequence = _pending.substr(2, end - 1);
+            _pending.erase(0, end + 1);
+            if (sequence == "A") {
+                return Up;
+            } else if (sequence == "B") {
+                return Down;
+            } else if (sequence == "C") {
+                return Right;
+            } else if (sequence == "D") {
+                return Left;
+            } else if (sequence == "H" || sequence == "1~") {
+                return Home;
+            } else if (sequence == "F" || sequence == "4~") {
+                return End;
+            } else if (sequence == "5~") {
+                return PageUp;
+            } else if (sequence == "6~") {
+                return PageDown;
+            } else if (sequence == "Z") {
+                return BackTab;
+            }
+            // Unknown sequence, ignored
+            return NoKey;
+        }
+
+      public:
+        /**
+         * Nothing is changed if the standard input isn't a terminal in the foreground: no key is ever read.
+         */
+        Keyboard() {
+            // A background process changing the terminal would be stopped by SIGTTOU
+            if (!isatty(STDIN_FILENO) || tcgetpgrp(STDIN_FILENO) != getpgrp() || detail::keyboard_enabled ||
+                    tcgetattr(STDIN_FILENO, &detail::saved_termios) != 0) {
+                return;
+            }
+
+            detail::raw_termios = detail::saved_termios;
+            detail::raw_termios.c_lflag &= ~static_cast<tcflag_t>(ICANON | ECHO);
+            detail::raw_termios.c_cc[VMIN] = 0;
+            detail::raw_termios.c_cc[VTIME] = 0;
+
+            detail::install_signal_handlers();
+            detail::keyboard_enabled = 1;
+            detail::enter_raw_mode();
+            _enabled = true;
+        }
+
+        Keyboard(const Keyboard &) = delete;
+        Keyboard &operator=(const Keyboard &) = delete;
+
+        ~Keyboard() {
+            if (!_enabled) {
+                return;
+            }
+            detail::keyboard_enabled = 0;
+            detail::restore_terminal();
+            detail::uninstall_signal_handlers();
+        }
+
+        bool is_enabled() const {
+            return _enabled;
+        }
+
+        /**
+         * Wait at most `timeout` for a key: a character, or a `Key` for the escape sequences. Return NoKey on timeout.
+         */
+        int read_key(std::chrono::milliseconds timeout) {
+            if (!_enabled) {
+                return NoKey;
+            }
+            const auto deadline = std::chrono::steady_clock::now() + timeout;
+            for (;;) {
+                while (!_pending.empty()) {
+                    const auto size = _pending.size();
+                    const int key = decode();
+                    if (_pending.size() == size) {
+                        // Incomplete escape sequence: wait for its end
+                        break;
+                    }
+                    _incomplete_since = {};
+                    if (key != NoKey) {
+                        return key;
+                    }
+                }
+
+                const auto now = std::chrono::steady_clock::now();
+                auto wake_up = deadline;
+                if (!_pending.empty()) {
+                    if (_incomplete_since == std::chrono::steady_clock::time_point{}) {
+                        _incomplete_since = now;
+                    }
+                    const auto expiry = _incomplete_since + _escape_delay;
+                    if (now >= expiry) {
+                        // Nothing followed: the Escape key
+                        _incomplete_since = {};
+                        _pending.erase(0, 1);
+                        return '\e';
+                    }
+                    wake_up = std::min(deadline, expiry);
+                }
+
+                const auto remaining = std::chrono::ceil<std::chrono::milliseconds>(wake_up - now);
+                pollfd fd{STDIN_FILENO, POLLIN, 0};
+                const int ready = poll(&fd, 1, static_cast<int>(std::max<long>(0, remaining.count())));
+                if (ready < 0 && errno == EINTR) {
+                    continue;
+                }
+                if (ready < 0 || (ready == 0 && std::chrono::steady_clock::now() >= deadline)) {
+                    return NoKey;
+                }
+                if (ready == 0) {
+                    continue;
+                }
+
+                char buffer[64];
+                const auto n = read(STDIN_FILENO, buffer, sizeof(buffer));
+                if (n <= 0) {
+                    return NoKey;
+                }
+                _pending.append(buffer, static_cast<std::size_t>(n));
+            }
+        }
+    };
+}
+
+#endif //AWESOME_VIEWER_KEYBOARD_H
@@ -0,0 +1,457 @@
+//
+// Created by terae on 19/10/26.
+//
+
+#ifndef AWESOME_VIEWER_LAYOUT_H
+#define AWESOME_VIEWER_LAYOUT_H
+
+#include "Cell.hpp"
+#include "Pixel.hpp"
+#include "Width.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <ctime>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace AwesomeViewer {
+
+    /**
+     * CPU time of the rendering thread allowed to the updates of one frame, zero meaning unlimited.
+     */
+    class FrameBudget {
+        std::chrono::nanoseconds _budget;
+        std::chrono::nanoseconds _start{};
+        bool _exhausted = false;
+        bool _cancelled = false;
+
+        static std::chrono::nanoseconds thread_cpu_time() {
+            timespec time{};
+            clock_gettime(CLOCK_THREAD_CPUTIME_ID, &time);
+            return std::chrono::seconds(time.tv_sec) + std::chrono::nanoseconds(time.tv_nsec);
+        }
+
+      public:
+        // Number of updates skipped because the budget was spent
+        std::size_t skipped = 0;
+
+        explicit FrameBudget(std::chrono::nanoseconds budget = std::chrono::nanoseconds::zero()) : _budget(budget) {
+            if (is_limited()) {
+                _start = thread_cpu_time();
+            }
+        }
+
+        bool is_limited() const {
+            return _budget > std::chrono::nanoseconds::zero();
+        }
+
+        bool is_exhausted() {
+            if (is_limited() && !_exhausted) {
+                _exhausted = thread_cpu_time() - _start >= _budget;
+            }
+            return _exhausted;
+        }
+
+        // No cell is updated anymore, e.g. once a cell of the layout is removed by an update: it may be destroyed
+        void cancel() {
+            _cancelled = true;
+        }
+
+        bool is_cancelled() const {
+            return _cancelled;
+        }
+    };
+
+    /**
+     * Grid of pixels in which the cells and their borders are placed.
+     * The layout shares the ownership of its cells, so that they outlive any pixel referencing them.
+     */
+    class Layout {
+        struct Coord {
+            unsigned int x, y;
+
+            friend bool operator==(const Coord &c1, const Coord &c2) {
+                return c1.x == c2.x && c1.y == c2.y;
+            }
+
+            friend std::ostream &operator<<(std::ostream &os, const Coord &c) {
+                return os << '[' << c.x << ',' << c.y << ']';
+            }
+        };
+
+        struct Entry {
+            std::shared_ptr<AbstractCell> cell;
+            std::string name;
+            Coord coord;
+        };
+
+        static constexpr Coord out_of_space = {std::numeric_limits<unsigned int>::max(),
+                                               std::numeric_limits<unsigned int>::max()
+                                              };
+
+        unsigned int _width;
+        unsigned int _height;
+
+        std::vector<std::vector<std::unique_ptr<AbstractPixel>>> _pixels;
+        std::vector<Entry> _entries;
+        // Cell whose name is highlighted
+        const AbstractCell *_focus = nullptr;
+        // Update order under a limited budget, only used by the rendering thread
+        mutable std::vector<AbstractCell *> _order;
+
+        void clear() {
+            _pixels.clear();
+            for (unsigned int y = 0; y < _height; ++y) {
+                std::vector<std::unique_ptr<AbstractPixel>> v;
+                for (unsigned int x = 0; x < _width; ++x) {
+                    v.emplace_back(nullptr);
+                }
+                _pixels.emplace_back(std::move(v));
+            }
+        }
+
+        // Whether the cell and its borders can be placed at `coord`, only overlapping other borders
+        bool fits(const AbstractCell &cell, const Coord &coord) const {
+            if (cell.get_width() + 4 > _width || coord.x > _width - cell.get_width() - 4 ||
+                    cell.get_height() + 2 > _height || coord.y > _height - cell.get_height() - 2) {
+                return false;
+            }
+            for (unsigned int Y = coord.y; Y < coord.y + cell.get_height() + 2; ++Y) {
+                for (unsigned int X = coord.x; X < coord.x + cell.get_width() + 4; ++X) {
+                    if (_pixels[Y][X] != nullptr && !_pixels[Y][X]->can_be_overwritten()) {
+                        return false;
+                    }
+                }
+            }
+            return true;
+        }
+
+        Coord get_free_space(const AbstractCell &cell) const {
+            bool found = false;
+            Coord result{std::numeric_limits<unsigned int>::max(), std::numeric_limits<unsigned int>::max()};
+            // The cell and its borders take (width + 4) x (height + 2) pixels
+            for (unsigned int y = 0; y + cell.get_height() + 2 <= _height && !found; ++y) {
+                for (unsigned int x = 0; x + cell.get_width() + 4 <= _width && !found; ++x) {
+                    bool interesting_cell = _pixels[y][x] == nullptr;
+                    if (!interesting_cell) {
+                        interesting_cell = _pixels[y][x]->can_be_overwritten();
+                    }
+
+                    if (interesting_cell && fits(cell, {x, y})) {
+                        found = true;
+                        result = {x, y};
+                    }
+                }
+            }
+            return result;
+        }
+
+        void insert_border(const Coord &coords, PixelType border) {
+            if (_pixels[coords.y][coords.x] == nullptr) {
+                _pixels[coords.y][coords.x] = std::make_unique<BorderPixel>(border);
+            } else {
+                try {
+                    auto &pixel = dynamic_cast<BorderPixel &>(*_pixels[coords.y][coords.x]);
+                    pixel.update_border_type(border);
+                } catch (std::bad_cast &) {
+                    std::stringstream what;
+                    what << "The pixel " << coords << " isn't a border.";
+                    throw std::runtime_error(what.str());
+                }
+            }
+        }
+
+        static void check_name_width(const AbstractCell &cell, const std::string &name) {
+            if (!name.empty() && cell.get_width() < 3) {
+                throw std::invalid_argument("A named cell must be at least 3 characters wide.");
+            }
+        }
+
+        void place(const Entry &entry) {
+            const AbstractCell &cell = *entry.cell;
+            const std::string &name = entry.name;
+            const Coord &space = entry.coord;
+
+            // Top border
+            unsigned int x = space.x;
+            unsigned int y = space.y;
+            insert_border({x++, y}, TopLeftCorner);
+            insert_border({x++, y}, HorizontalBorder);
+
+            if (name.empty()) {
+                for (unsigned int i = 0; i < cell.get_width() + 1; ++i) {
+                    insert_border({x++, y}, HorizontalBorder);
+                }
+            } else {
+                insert_border({x++, y}, EmptyBorder);
+
+                // The name pixel is followed by one empty pixel per other column it takes. It takes at least one
+                // column, a space when not even the first character of the name fits.
+                const auto prefix = prefix_of_width(name, cell.get_width() - 2);
+                const auto width = static_cast<unsigned int>(std::max<std::size_t>(1, prefix.width));
+                auto pixel = std::make_unique<CellNamePixel>(prefix.width == 0 ? std::string(" ") :
+                             name.substr(0, prefix.bytes));
+                pixel->set_focused(entry.cell.get() == _focus);
+                _pixels[y][x++] = std::move(pixel);
+                for (unsigned int i = 1; i < width; ++i) {
+                    _pixels[y][x++] = std::make_unique<EmptyPixel>();
+                }
+
+                insert_border({x++, y}, EmptyBorder);
+
+                for (unsigned int i = width; i + 1 < cell.get_width(); ++i) {
+                    insert_border({x++, y}, HorizontalBorder);
+                }
+            }
+
+            insert_border({x, y++}, TopRightCorner);
+
+            // Cell
+            for (unsigned int i = 0; i < cell.get_height(); ++i) {
+                x = space.x;
+                insert_border({x++, y}, VerticalBorder);
+                insert_border({x++, y}, EmptyBorder);
+
+                _pixels[y][x++] = std::make_unique<CellValuePixel>([&cell, i](std::string & out) {
+                    cell.append_nth_line(i, out);
+                });
+                for (unsigned int j = 0; j < cell.get_width() - 1; ++j) {
+                    _pixels[y][x++] = std::make_unique<EmptyPixel>();
+                }
+
+                insert_border({x++, y}, EmptyBorder);
+                insert_border({x, y++}, VerticalBorder);
+            }
+
+            // Bottom border
+            x = space.x;
+            insert_border({x++, y}, BottomLeftCorner);
+            for (unsigned i = 0; i < cell.get_width() + 2; ++i) {
+                insert_border({x++, y}, HorizontalBorder);
+            }
+            insert_border({x, y}, BottomRightCorner);
+        }
+
+      public:
+        Layout(unsigned int width, unsigned int height) : _width(width), _height(height) {
+            clear();
+        }
+
+        // The pixels are copied rather than placed again, and keep displaying the same cells
+        Layout(const Layout &other) : _width(other._width), _height(other._height), _entries(other._entries),
+            _focus(other._focus) {
+            _pixels.reserve(other._pixels.size());
+            for (const auto &line : other._pixels) {
+                auto &copy = _pixels.emplace_back();
+                copy.reserve(line.size());
+                for (const auto &pixel : line) {
+                    copy.push_back(pixel == nullptr ? nullptr : pixel->clone());
+                }
+            }
+        }
+
+        Layout &operator=(const Layout &) = delete;
+
+        /**
+         * A named cell is at least 3 characters wide, for its name and the spaces around it.
+         */
+        void add_cell(std::shared_ptr<AbstractCell> cell, const std::string &name = "") {
+            check_name_width(*cell, name);
+            Coord space = get_free_space(*cell);
+            if (space == out_of_space) {
+                throw std::runtime_error("No space left.");
+            }
+            _entries.push_back({std::move(cell), name, space});
+            place(_entries.back());
+        }
+
+        /**
+         * Place the cell at `x`, `y`, e.g. where it was in a previous run, without searching for a free space.
+         * Return false if it doesn't fit there.
+         */
+        bool add_cell_at(std::shared_ptr<AbstractCell> cell, const std::string &name, unsigned int x, unsigned int y) {
+            check_name_width(*cell, name);
+            if (!fits(*cell, {x, y})) {
+                return false;
+            }
+            _entries.push_back({std::move(cell), name, {x, y}});
+            place(_entries.back());
+            return true;
+        }
+
+        /**
+         * Remove a cell and its borders, the other cells keep their places. Return false if it isn't in the layout.
+         */
+        bool remove_cell(const AbstractCell &cell) {
+            auto it = std::find_if(_entries.cbegin(), _entries.cend(), [&cell](const Entry & entry) {
+                return entry.cell.get() == &cell;
+            });
+            if (it == _entries.cend()) {
+                return false;
+            }
+            _entries.erase(it);
+
+            clear();
+            for (const auto &entry : _entries) {
+                place(entry);
+            }
+            return true;
+        }
+
+        /**
+         * Refresh the cells whose content expired; with `missing_only`, only the cells which have never been updated.
+         */
+        void update(AbstractCell::Clock::time_point now, bool missing_only = false) const {
+            FrameBudget unlimited;
+            update(now, unlimited, missing_only);
+        }
+
+        /**
+         * With a limited `budget`, the cells are updated by decreasing priority, the least recently updated first
+         * among the cells of the same priority: the low-priority cells aren't updated once the budget is spent.
+         */
+        void update(AbstractCell::Clock::time_point now, FrameBudget &budget, bool missing_only = false) const {
+            if (!budget.is_limited()) {
+                for (const auto &entry : _entries) {
+                    if (budget.is_cancelled()) {
+                        return;
+                    }
+                    if (!missing_only || !entry.cell->has_data()) {
+                        entry.cell->refresh(now);
+                    }
+                }
+                return;
+            }
+
+            _order.clear();
+            for (const auto &entry : _entries) {
+                if ((!missing_only || !entry.cell->has_data()) && entry.cell->is_due(now)) {
+                    _order.push_back(entry.cell.get());
+                }
+            }
+            std::sort(_order.begin(), _order.end(), [](const AbstractCell * a, const AbstractCell * b) {
+                if (a->get_priority() != b->get_priority()) {
+                    return a->get_priority() > b->get_priority();
+                }
+                return a->get_last_refresh() < b->get_last_refresh();
+            });
+
+            for (auto *cell : _order) {
+                if (budget.is_cancelled()) {
+                    return;
+                }
+                if (cell->get_priority() != Priority::Critical && budget.is_exhausted()) {
+                    ++budget.skipped;
+                } else {
+                    cell->refresh(now);
+                }
+            }
+        }
+
+        // Call `f(name, cell)` for each cell of the layout
+        template<class F>
+        void for_each_cell(F &&f) const {
+            for (const auto &entry : _entries) {
+                f(entry.name, static_cast<const AbstractCell &>(*entry.cell));
+            }
+        }
+
+        // Call `f(name, cell, x, y)` for each cell of the layout, with the position of its top-left corner
+        template<class F>
+        void for_each_placement(F &&f) const {
+            for (const auto &entry : _entries) {
+                f(entry.name, static_cast<const AbstractCell &>(*entry.cell), entry.coord.x, entry.coord.y);
+            }
+        }
+
+        // The cell `offset` places after `cell` in the order of insertion, cycling; the first one if `cell` isn't found
+        AbstractCell *cycle_cell(const AbstractCell *cell, long offset) const {
+            if (_entries.empty()) {
+                return nullptr;
+            }
+            const auto count = static_cast<long>(_entries.size());
+            auto it = std::find_if(_entries.cbegin(), _entries.cend(), [cell](const Entry & entry) {
+                return entry.cell.get() == cell;
+            });
+            if (it == _entries.cend()) {
+                return _entries.front().cell.get();
+            }
+            const auto index = ((it - _entries.cbegin() + offset) % count + count) % count;
+            return _entries[static_cast<std::size_t>(index)].cell.get();
+        }
+
+        const AbstractCell *get_focus() const {
+            return _focus;
+        }
+
+        // `cell` if it is in the layout, nullptr otherwise
+        AbstractCell *find_cell(const AbstractCell *cell) const {
+            auto it = std::find_if(_entries.cbegin(), _entries.cend(), [cell](const Entry & entry) {
+                return entry.cell.get() == cell;
+            });
+            return it == _entries.cend() ? nullptr : it->cell.get();
+        }
+
+        /**
+         * Highlight the name of `cell`, and only its name. A published layout is immutable: change the focus of a copy.
+         */
+        void set_focus(const AbstractCell *cell) {
+            _focus = cell;
+            for (const auto &entry : _entries) {
+                if (!entry.name.empty()) {
+                    auto &pixel = static_cast<CellNamePixel &>(*_pixels[entry.coord.y][entry.coord.x + 3]);
+                    pixel.set_focused(entry.cell.get() == cell);
+                }
+            }
+        }
+
+        /**
+         * Append the name and the lines of `cell` to `out`, each one preceded by `move(x, y)`, the escape sequence
+         * moving the cursor to its position in the layout. Return false if the cell isn't in the layout.
+         */
+        template<class Move>
+        bool compose_cell(const AbstractCell &cell, std::string &out, Move &&move) const {
+            auto it = std::find_if(_entries.cbegin(), _entries.cend(), [&cell](const Entry & entry) {
+                return entry.cell.get() == &cell;
+            });
+            if (it == _entries.cend()) {
+                return false;
+            }
+
+            const Coord &space = it->coord;
+            if (!it->name.empty()) {
+                out += move(space.x + 3, space.y);
+                _pixels[space.y][space.x + 3]->append_to(out);
+            }
+            for (unsigned int i = 0; i < cell.get_height(); ++i) {
+                out += move(space.x + 2, space.y + 1 + i);
+                _pixels[space.y + 1 + i][space.x + 2]->append_to(out);
+            }
+            return true;
+        }
+
+        // Append the lines of the layout to `next`, using the current content of the cells
+        void compose(std::string &next) const {
+            for (const auto &line : _pixels) {
+                for (const auto &pixel : line) {
+                    if (pixel == nullptr) {
+                        next += ' ';
+                    } else {
+                        pixel->append_to(next);
+                    }
+                }
+                next += '\n';
+            }
+            // remove the last `\n`
+            next.pop_back();
+        }
+    };
+}
+
+#endif //AWESOME_VIEWER_LAYOUT_H
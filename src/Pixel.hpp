@@ -6,7 +6,12 @@
 #define AWESOME_VIEWER_PIXEL_H
 
 #include "Style.hpp"
+
 #include <functional>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
 
 namespace AwesomeViewer {
     enum PixelType {
@@ -41,45 +46,18 @@ namespace AwesomeViewer {
         return static_cast<PixelType>(p1 | p2);
     }
 
-    inline std::string get_symbol_of(PixelType type) {
-        switch (type) {
-            case EmptyBorder:
-                return " ";
-            case HorizontalLeftBorder:
-                return "─";
-            case HorizontalRightBorder:
-                return "─";
-            case HorizontalBorder:
-                return "─";
-            case VerticalTopBorder:
-                return "│";
-            case VerticalBottomBorder:
-                return "│";
-            case VerticalBorder:
-                return "│";
-            case TopLeftCorner:
-                return "┌";
-            case TopRightCorner:
-                return "┐";
-            case BottomLeftCorner:
-                return "└";
-            case BottomRightCorner:
-                return "┘";
-            case HorizontalTopT:
-                return "┬";
-            case HorizontalBottomT:
-                return "┴";
-            case VerticalRightT:
-                return "┤";
-            case VerticalLeftT:
-                return "├";
-            case Cross:
-                return "┼";
-            case CellName:
-            case CellValue:
-            default:
-                throw std::invalid_argument("None associated symbol.");
+    namespace detail {
+        // UTF-8 encoding of the border glyphs, indexed by the bits 'bottom | top | left | right' of their type
+        constexpr std::string_view border_glyphs[16] = {
+            " ", "─", "─", "─", "│", "┐", "┌", "┬", "│", "┘", "└", "┴", "│", "┤", "├", "┼"
+        };
+    }
+
+    inline std::string_view get_symbol_of(PixelType type) {
+        if (type < 0 || type > Cross) {
+            throw std::invalid_argument("None associated symbol.");
         }
+        return detail::border_glyphs[type];
     }
 
     class AbstractPixel {
@@ -89,6 +67,12 @@ namespace AwesomeViewer {
 
       public:
         virtual std::string to_string() const = 0;
+        virtual std::unique_ptr<AbstractPixel> clone() const = 0;
+
+        // Same as `out += to_string()`, without an intermediate string
+        virtual void append_to(std::string &out) const {
+            out += to_string();
+        }
         virtual ~AbstractPixel() = default;
 
         constexpr PixelType get_type() const {
@@ -107,6 +91,12 @@ namespace AwesomeViewer {
         std::string to_string() const override {
             return "";
         }
+
+        void append_to(std::string &) const override {}
+
+        std::unique_ptr<AbstractPixel> clone() const override {
+            return std::make_unique<EmptyPixel>(*this);
+        }
     };
 
     class CellNamePixel : public AbstractPixel {
@@ -119,22 +109,49 @@ namespace AwesomeViewer {
             _type = CellName;
         }
 
+        // The name of the cell receiving the keys is highlighted like the displayed page
+        void set_focused(bool focused) {
+            _style = (focused ? Style(Font::Bold, FontColor::Black, Color::Cyan) : Style(FontColor::Cyan));
+        }
+
         std::string to_string() const override {
             return _style.to_string() + _name;
         }
+
+        void append_to(std::string &out) const override {
+            out += _style.to_string();
+            out += _name;
+        }
+
+        std::unique_ptr<AbstractPixel> clone() const override {
+            return std::make_unique<CellNamePixel>(*this);
+        }
     };
 
     class CellValuePixel : public AbstractPixel {
       private:
-        std::function<std::string()> _value;
+        // Appends the value to its argument
+        std::function<void(std::string &)> _value;
 
       public:
-        explicit CellValuePixel(std::function<std::string()> value) : _value(std::move(value)) {
+        explicit CellValuePixel(std::function<void(std::string &)> value) : _value(std::move(value)) {
             _type = CellValue;
         }
 
         std::string to_string() const override {
-            return _style.to_string() + _value();
+            std::string result;
+            append_to(result);
+            return result;
+        }
+
+        void append_to(std::string &out) const override {
+            out += _style.to_string();
+            _value(out);
+        }
+
+        // The copy displays the same cell
+        std::unique_ptr<AbstractPixel> clone() const override {
+            return std::make_unique<CellValuePixel>(*this);
         }
     };
 
@@ -150,7 +167,20 @@ namespace AwesomeViewer {
         }
 
         std::string to_string() const override {
-            return _style.to_string() + get_symbol_of(_type);
+            std::string result;
+            append_to(result);
+            return result;
+        }
+
+        void append_to(std::string &out) const override {
+            // The style of the borders never changes
+            static const std::string style = Style(FontColor::Black, Font::Bold).to_string();
+            out += style;
+            out += get_symbol_of(_type);
+        }
+
+        std::unique_ptr<AbstractPixel> clone() const override {
+            return std::make_unique<BorderPixel>(*this);
         }
     };
 }
@@ -0,0 +1,188 @@
+//
+// Created by terae on 19/10/26.
+//
+
+#ifndef AWESOME_VIEWER_RATECELL_H
+#define AWESOME_VIEWER_RATECELL_H
+
+#include "Cell.hpp"
+#include "Format.hpp"
+#include "Width.hpp"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace AwesomeViewer {
+
+    /**
+     * Monotonic event counter, alone on its cache line: producers only pay one relaxed increment per event.
+     */
+    struct alignas(64) Counter : std::atomic<std::uint64_t> {
+        Counter() : std::atomic<std::uint64_t>(0) {}
+
+        inline void add(std::uint64_t n = 1) {
+            fetch_add(n, std::memory_order_relaxed);
+        }
+    };
+
+    class RateCell final : public AbstractCell {
+      public:
+        using Clock = std::chrono::steady_clock;
+
+      private:
+        // Time constants of the exponentially weighted moving averages
+        static constexpr std::array<double, 3> _windows = {1.0, 10.0, 60.0};
+        static constexpr std::array<const char *, 4> _labels = {"now", "1s", "10s", "1m"};
+
+        struct Series {
+            std::string name;
+            const std::atomic<std::uint64_t> *counter;
+            std::uint64_t first_value = 0;
+            std::uint64_t last_value = 0;
+            double instant = 0.0;
+            std::array<double, _windows.size()> averages{};
+            bool sampled = false;
+        };
+
+        std::vector<Series> _series;
+        std::string _unit;
+        Clock::time_point _start;
+        Clock::time_point _last_sample;
+        bool _started = false;
+
+        void sample(Clock::time_point now) {
+            const double elapsed = std::chrono::duration<double>(now - _last_sample).count();
+            const double lifetime = std::chrono::duration<double>(now - _start).count();
+
+            if (!_started) {
+                for (auto &series : _series) {
+                    series.first_value = series.last_value = series.counter->load(std::memory_order_relaxed);
+                }
+                _started = true;
+                _start = _last_sample = now;
+                return;
+            }
+            // Too close to the previous sample to be meaningful
+            if (elapsed < 1e-3) {
+                return;
+            }
+
+            for (auto &series : _series) {
+                const auto value = series.counter->load(std::memory_order_relaxed);
+                const auto delta = (value >= series.last_value ? value - series.last_value : 0);
+                series.last_value = value;
+                series.instant = static_cast<double>(delta) / elapsed;
+
+                for (std::size_t i = 0; i < _windows.size(); ++i) {
+                    if (lifetime < _windows[i]) {
+                        // Not enough history yet: plain average since the first sample
+                        series.averages[i] = static_cast<double>(value - std::min(value, series.first_value)) / lifetime;
+                    } else {
+                        const double alpha = 1.0 - std::exp(-elapsed / _windows[i]);
+                        series.averages[i] += alpha * (series.instant - series.averages[i]);
+                    }
+                }
+                series.sampled = true;
+            }
+            _last_sample = now;
+        }
+
+      public:
+        /**
+         * Each row shows the instantaneous rate of a counter and its moving averages over 1s, 10s and 1m.
+         * The counters are sampled at each `update`, using the elapsed time measured by the viewer.
+         */
+        RateCell(unsigned int width, unsigned int height,
+                 const std::vector<std::pair<std::string, const std::atomic<std::uint64_t> *>> &counters,
+                 std::string unit = "") :
+            AbstractCell(width, height), _unit(std::move(unit)) {
+            for (const auto &counter : counters) {
+                _series.push_back({counter.first, counter.second});
+            }
+        }
+
+        ~RateCell() override = default;
+
+        const char *get_type() const override {
+            return "rate";
+        }
+
+        void export_to(Exporter &exporter) const override {
+            for (const auto &series : _series) {
+                if (series.sampled) {
+                    exporter.entry(series.name + '.' + _labels[0], series.instant);
+                    for (std::size_t i = 0; i < _windows.size(); ++i) {
+                        exporter.entry(series.name + '.' + _labels[i + 1], series.averages[i]);
+                    }
+                }
+            }
+        }
+
+        void update() override {
+            update(Clock::now());
+        }
+
+        // Sample the counters as if it was `now`, which never goes back
+        void update(Clock::time_point now) {
+            _data.clear();
+            sample(now);
+
+            unsigned int max_size = 0;
+            for (const auto &series : _series) {
+                max_size = std::max(max_size, static_cast<unsigned int>(display_width(series.name)));
+            }
+            max_size = std::min(max_size, _width > 3 ? _width - 3 : 0);
+
+            const unsigned int available = _width - std::min(_width, max_size + 3);
+            const unsigned int columns = std::max(1u, std::min(static_cast<unsigned int>(_labels.size()), available / 8));
+            const unsigned int column_width = available / columns;
+            const unsigned int padding = available - columns * column_width;
+
+            if (_height > _series.size()) {
+                std::string header(_width, ' ');
+                for (unsigned int c = 0; c < columns; ++c) {
+                    auto field = std::span<char>(header).subspan(_width - available + padding + c * column_width,
+                                 column_width);
+                    format_aligned(field, _labels[c], Align::Right);
+                }
+                _data.emplace_back(Style(FontColor::Black, Font::Bold), std::move(header));
+            }
+
+            for (const auto &series : _series) {
+                if (_data.size() == _height) {
+                    break;
+                }
+
+                StyleString result;
+                const auto key_width = std::min(max_size, _width);
+                std::string key = align_to_width(series.name, key_width, Align::Right);
+                key.append(" : ", std::min(_width, max_size + 3) - key_width);
+                result.insert(Style(FontColor::Black, Font::Bold), std::move(key));
+
+                std::string values(available, ' ');
+                for (unsigned int c = 0; c < columns; ++c) {
+                    auto field = std::span<char>(values).subspan(padding + c * column_width, column_width);
+                    if (!series.sampled) {
+                        format_aligned(field, "-", Align::Right);
+                    } else {
+                        format_rate(field, c == 0 ? series.instant : series.averages[c - 1], _unit);
+                    }
+                }
+                result.insert(Style::Default(), std::move(values));
+                _data.push_back(result);
+            }
+
+            while (_data.size() < _height) {
+                _data.emplace_back(Style::Default(), std::string(_width, ' '));
+            }
+        }
+    };
+}
+
+#endif //AWESOME_VIEWER_RATECELL_H
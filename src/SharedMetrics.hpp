@@ -0,0 +1,399 @@
+//
+// Created by terae on 19/10/26.
+//
+
+#ifndef AWESOME_VIEWER_SHAREDMETRICS_H
+#define AWESOME_VIEWER_SHAREDMETRICS_H
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <fcntl.h>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+namespace AwesomeViewer {
+
+    enum class SlotType : std::uint32_t {
+        Counter = 1,
+        Gauge = 2,
+        Text = 3
+    };
+
+    namespace detail {
+        static_assert(std::atomic<std::uint32_t>::is_always_lock_free);
+        static_assert(std::atomic<std::uint64_t>::is_always_lock_free);
+
+        constexpr std::uint64_t shared_magic = 0x3148535657565741; // "AWVWSHS1"
+        constexpr std::uint32_t shared_format_version = 1;
+        constexpr std::size_t slot_name_size = 48;
+        constexpr std::size_t slot_words = 6;
+
+        /**
+         * Beginning of the segment. The descriptors of the slots are only appended, between two increments of
+         * `layout_version`: it is odd while a slot is being registered.
+         */
+        struct SharedHeader {
+            std::uint64_t magic;
+            std::uint32_t format_version;
+            std::uint32_t capacity;
+            std::atomic<std::uint32_t> layout_version;
+            std::atomic<std::uint32_t> slot_count;
+        };
+
+        /**
+         * Counters and gauges are a single word, stored atomically. Texts span several words, protected by the
+         * `sequence` seqlock: it is odd while the text is being written.
+         */
+        struct alignas(64) SharedSlot {
+            char name[slot_name_size];
+            SlotType type;
+            std::atomic<std::uint32_t> sequence;
+            std::atomic<std::uint64_t> words[slot_words];
+        };
+
+        inline std::size_t segment_size(std::uint32_t capacity) {
+            return sizeof(SharedSlot) * (capacity + 1);
+        }
+
+        inline SharedSlot *slots_of(void *segment) {
+            return reinterpret_cast<SharedSlot *>(static_cast<char *>(segment) + sizeof(SharedSlot));
+        }
+
+        static_assert(sizeof(SharedHeader) <= sizeof(SharedSlot));
+    }
+
+    class SharedCounter {
+        std::atomic<std::uint64_t> *_value;
+
+      public:
+        explicit SharedCounter(std::atomic<std::uint64_t> *value) : _value(value) {}
+
+        inline void add(std::uint64_t n = 1) {
+            _value->fetch_add(n, std::memory_order_relaxed);
+        }
+
+        inline void set(std::uint64_t value) {
+            _value->store(value, std::memory_order_relaxed);
+        }
+
+        // Can be given to a `RateCell` of the producer itself
+        const std::atomic<std::uint64_t> *value() const {
+            return _value;
+        }
+    };
+
+    class SharedGauge {
+        std::atomic<std::uint64_t> *_value;
+
+      public:
+        explicit SharedGauge(std::atomic<std::uint64_t> *value) : _value(value) {}
+
+        inline void set(double value) {
+            _value->store(std::bit_cast<std::uint64_t>(value), std::memory_order_relaxed);
+        }
+    };
+
+    /**
+     * Up to 48 bytes, the rest is truncated. A text has only one writer at a time.
+     */
+    class SharedText {
+        detail::SharedSlot *_slot;
+
+      public:
+        static constexpr std::size_t max_size = sizeof(std::uint64_t) * detail::slot_words;
+
+        explicit SharedText(detail::SharedSlot *slot) : _slot(slot) {}
+
+        void set(std::string_view text) {
+            std::uint64_t words[detail::slot_words] = {};
+            std::memcpy(words, text.data(), std::min(text.size(), max_size));
+
+            const auto sequence = _slot->sequence.load(std::memory_order_relaxed);
+            _slot->sequence.store(sequence + 1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+            for (std::size_t i = 0; i < detail::slot_words; ++i) {
+                _slot->words[i].store(words[i], std::memory_order_relaxed);
+            }
+            _slot->sequence.store(sequence + 2, std::memory_order_release);
+        }
+    };
+
+    /**
+     * Producer side: metrics published in a POSIX shared memory segment, rendered by a separate `AwesomeViewer`
+     * process. Updating a metric is a store into the mapped memory, nothing is formatted nor written by the producer.
+     * The segment is removed by the destructor, unless another producer replaced it meanwhile.
+     */
+    class SharedMetrics {
+        std::string _name;
+        std::uint32_t _capacity;
+        void *_segment = nullptr;
+        // Kept open to recognise the segment behind the name
+        int _fd = -1;
+        std::mutex _registering;
+
+        // Whether the name still refers to the segment created by this producer
+        bool owns_name() const {
+            int fd = shm_open(_name.c_str(), O_RDONLY, 0);
+            if (fd < 0) {
+                return false;
+            }
+            struct stat named{}, own{};
+            const bool same = fstat(fd, &named) == 0 && fstat(_fd, &own) == 0 &&
+                              named.st_dev == own.st_dev && named.st_ino == own.st_ino;
+            close(fd);
+            return same;
+        }
+
+        detail::SharedSlot &register_slot(std::string_view name, SlotType type) {
+            std::lock_guard<std::mutex> lock(_registering);
+            auto &header = *static_cast<detail::SharedHeader *>(_segment);
+            const auto index = header.slot_count.load(std::memory_order_relaxed);
+            if (index == _capacity) {
+                throw std::runtime_error("No slot left in the shared segment \"" + _name + "\".");
+            }
+
+            const auto version = header.layout_version.load(std::memory_order_relaxed);
+            header.layout_version.store(version + 1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+
+            auto &slot = detail::slots_of(_segment)[index];
+            std::memset(slot.name, 0, sizeof(slot.name));
+            std::memcpy(slot.name, name.data(), std::min(name.size(), sizeof(slot.name) - 1));
+            slot.type = type;
+            header.slot_count.store(index + 1, std::memory_order_release);
+            header.layout_version.store(version + 2, std::memory_order_release);
+            return slot;
+        }
+
+      public:
+        /**
+         * `name` is the name of the segment, e.g. "/my_application". Throws if a segment of the same name exists, e.g.
+         * owned by another producer, unless `replace` is set: e.g. left by a previous run which was killed.
+         * The viewer groups the slots by the prefix of their names, before the first '.'.
+         */
+        explicit SharedMetrics(std::string name, std::uint32_t capacity = 256, bool replace = false) :
+            _name(std::move(name)), _capacity(capacity) {
+            if (replace) {
+                shm_unlink(_name.c_str());
+            }
+            _fd = shm_open(_name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0644);
+            if (_fd < 0) {
+                throw std::runtime_error("Unable to create the shared segment \"" + _name + "\": " +
+                                         std::strerror(errno));
+            }
+            const auto size = detail::segment_size(_capacity);
+            if (ftruncate(_fd, static_cast<off_t>(size)) != 0) {
+                close(_fd);
+                shm_unlink(_name.c_str());
+                throw std::runtime_error("Unable to size the shared segment \"" + _name + "\".");
+            }
+            _segment = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, _fd, 0);
+            if (_segment == MAP_FAILED) {
+                close(_fd);
+                shm_unlink(_name.c_str());
+                throw std::runtime_error("Unable to map the shared segment \"" + _name + "\".");
+            }
+
+            // The segment is zero-filled: the magic number is written last, so that a viewer never sees a partial header
+            auto &header = *static_cast<detail::SharedHeader *>(_segment);
+            header.format_version = detail::shared_format_version;
+            header.capacity = _capacity;
+            std::atomic_ref<std::uint64_t>(header.magic).store(detail::shared_magic, std::memory_order_release);
+        }
+
+        SharedMetrics(const SharedMetrics &) = delete;
+        SharedMetrics &operator=(const SharedMetrics &) = delete;
+
+        ~SharedMetrics() {
+            munmap(_segment, detail::segment_size(_capacity));
+            if (owns_name()) {
+                shm_unlink(_name.c_str());
+            }
+            close(_fd);
+        }
+
+        SharedCounter add_counter(std::string_view name) {
+            return SharedCounter(&register_slot(name, SlotType::Counter).words[0]);
+        }
+
+        SharedGauge add_gauge(std::string_view name) {
+            return SharedGauge(&register_slot(name, SlotType::Gauge).words[0]);
+        }
+
+        SharedText add_text(std::string_view name) {
+            return SharedText(&register_slot(name, SlotType::Text));
+        }
+    };
+
+    /**
+     * Viewer side: read-only mapping of a segment created by `SharedMetrics`.
+     */
+    class SharedMetricsReader {
+      public:
+        struct SlotInfo {
+            std::string name;
+            SlotType type;
+        };
+
+      private:
+        std::string _name;
+        std::size_t _size = 0;
+        void *_segment = nullptr;
+        ino_t _inode = 0;
+        // Set once a seqlock stays odd: the producer died while writing
+        mutable std::atomic<bool> _abandoned{false};
+
+        // A writer holds a seqlock for a few copies: beyond this delay, it won't release it
+        static constexpr std::chrono::milliseconds _writer_timeout{100};
+
+        const detail::SharedHeader &header() const {
+            return *static_cast<const detail::SharedHeader *>(_segment);
+        }
+
+        const detail::SharedSlot &slot(std::size_t index) const {
+            return detail::slots_of(_segment)[index];
+        }
+
+      public:
+        /**
+         * Throws if the segment doesn't exist (yet), or if it has been created by an incompatible version.
+         */
+        explicit SharedMetricsReader(std::string name) : _name(std::move(name)) {
+            int fd = shm_open(_name.c_str(), O_RDONLY, 0);
+            if (fd < 0) {
+                throw std::runtime_error("Unable to open the shared segment \"" + _name + "\": " +
+                                         std::strerror(errno));
+            }
+            struct stat status{};
+            if (fstat(fd, &status) != 0 || static_cast<std::size_t>(status.st_size) < sizeof(detail::SharedSlot)) {
+                close(fd);
+                throw std::runtime_error("The shared segment \"" + _name + "\" isn't initialized.");
+            }
+            _size = static_cast<std::size_t>(status.st_size);
+            _inode = status.st_ino;
+            _segment = mmap(nullptr, _size, PROT_READ, MAP_SHARED, fd, 0);
+            close(fd);
+            if (_segment == MAP_FAILED) {
+                throw std::runtime_error("Unable to map the shared segment \"" + _name + "\".");
+            }
+
+            // Mapped read-only: only loaded, through a non-const reference as `atomic_ref` requires
+            auto &magic_word = const_cast<std::uint64_t &>(header().magic);
+            const auto magic = std::atomic_ref<std::uint64_t>(magic_word).load(std::memory_order_acquire);
+            if (magic != detail::shared_magic || header().format_version != detail::shared_format_version ||
+                    detail::segment_size(header().capacity) > _size) {
+                munmap(_segment, _size);
+                throw std::runtime_error("The shared segment \"" + _name + "\" has an unknown format.");
+            }
+        }
+
+        SharedMetricsReader(const SharedMetricsReader &) = delete;
+        SharedMetricsReader &operator=(const SharedMetricsReader &) = delete;
+
+        ~SharedMetricsReader() {
+            munmap(_segment, _size);
+        }
+
+        // Changes each time a slot is registered
+        std::uint32_t layout_version() const {
+            return header().layout_version.load(std::memory_order_acquire);
+        }
+
+        /**
+         * True once the producer has removed the segment, or replaced it by a new one, or died while writing to it.
+         */
+        bool is_stale() const {
+            if (_abandoned.load(std::memory_order_relaxed)) {
+                return true;
+            }
+            int fd = shm_open(_name.c_str(), O_RDONLY, 0);
+            if (fd < 0) {
+                return true;
+            }
+            struct stat status{};
+            const bool same = fstat(fd, &status) == 0 && status.st_ino == _inode;
+            close(fd);
+            return !same;
+        }
+
+        // Consistent list of the slots, their index is their position. Empty, and stale, if the producer died
+        // while registering a slot.
+        std::vector<SlotInfo> slots(std::uint32_t *version = nullptr) const {
+            std::vector<SlotInfo> result;
+            const auto deadline = std::chrono::steady_clock::now() + _writer_timeout;
+            while (!_abandoned.load(std::memory_order_relaxed)) {
+                const auto before = header().layout_version.load(std::memory_order_acquire);
+                if (before % 2 == 0) {
+                    const auto count = std::min(header().slot_count.load(std::memory_order_acquire), header().capacity);
+                    result.clear();
+                    for (std::uint32_t i = 0; i < count; ++i) {
+                        const auto &s = slot(i);
+                        result.push_back({std::string(s.name, strnlen(s.name, sizeof(s.name))), s.type});
+                    }
+                    std::atomic_thread_fence(std::memory_order_acquire);
+                    if (header().layout_version.load(std::memory_order_relaxed) == before) {
+                        if (version != nullptr) {
+                            *version = before;
+                        }
+                        return result;
+                    }
+                }
+                if (std::chrono::steady_clock::now() >= deadline) {
+                    _abandoned.store(true, std::memory_order_relaxed);
+                }
+                std::this_thread::yield();
+            }
+            return {};
+        }
+
+        std::uint64_t read_counter(std::size_t index) const {
+            return slot(index).words[0].load(std::memory_order_relaxed);
+        }
+
+        double read_gauge(std::size_t index) const {
+            return std::bit_cast<double>(slot(index).words[0].load(std::memory_order_relaxed));
+        }
+
+        // Empty, and stale, if the producer died while writing the text
+        std::string read_text(std::size_t index) const {
+            const auto &s = slot(index);
+            std::uint64_t words[detail::slot_words];
+            const auto deadline = std::chrono::steady_clock::now() + _writer_timeout;
+            for (;;) {
+                if (_abandoned.load(std::memory_order_relaxed)) {
+                    return {};
+                }
+                const auto before = s.sequence.load(std::memory_order_acquire);
+                if (before % 2 == 0) {
+                    for (std::size_t i = 0; i < detail::slot_words; ++i) {
+                        words[i] = s.words[i].load(std::memory_order_relaxed);
+                    }
+                    std::atomic_thread_fence(std::memory_order_acquire);
+                    if (s.sequence.load(std::memory_order_relaxed) == before) {
+                        break;
+                    }
+                }
+                if (std::chrono::steady_clock::now() >= deadline) {
+                    _abandoned.store(true, std::memory_order_relaxed);
+                }
+                std::this_thread::yield();
+            }
+            const char *chars = reinterpret_cast<const char *>(words);
+            return std::string(chars, strnlen(chars, sizeof(words)));
+        }
+    };
+}
+
+#endif //AWESOME_VIEWER_SHAREDMETRICS_H
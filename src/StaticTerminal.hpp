@@ -0,0 +1,284 @@
+//
+// Created by terae on 19/10/26.
+//
+
+#ifndef AWESOME_VIEWER_STATICTERMINAL_H
+#define AWESOME_VIEWER_STATICTERMINAL_H
+
+#include "Cell.hpp"
+#include "Format.hpp"
+#include "Layout.hpp"
+#include "Style.hpp"
+#include "utils.hpp"
+#include "Width.hpp"
+
+#include <algorithm>
+#include <array>
+#include <concepts>
+#include <cstddef>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <sys/ioctl.h>
+#include <tuple>
+#include <type_traits>
+#include <unistd.h>
+#include <utility>
+#include <vector>
+
+namespace AwesomeViewer {
+
+    /**
+     * Cell of a `StaticTerminal`: its size is known at compile time, and `append_line` appends exactly `width`
+     * displayed characters, styles included.
+     */
+    template<class T>
+    concept StaticCell = requires(T cell, const T const_cell, std::string &out, unsigned int line) {
+        { T::width } -> std::convertible_to<unsigned int>;
+        { T::height } -> std::convertible_to<unsigned int>;
+        { const_cell.name() } -> std::convertible_to<std::string_view>;
+        cell.update();
+        const_cell.append_line(out, line);
+    };
+
+    /**
+     * Same rendering as `StringCell`: one line of text per '\n', truncated or padded to `W` columns.
+     * `Generator` returns a text convertible to `std::string_view`.
+     */
+    template<unsigned int W, unsigned int H, class Generator>
+    class StaticStringCell {
+        std::string _name;
+        Generator _generator;
+        // Their storage is reused by each update
+        std::array<std::string, H> _lines;
+
+      public:
+        static constexpr unsigned int width = W;
+        static constexpr unsigned int height = H;
+
+        StaticStringCell(std::string name, Generator generator) : _name(std::move(name)),
+            _generator(std::move(generator)) {}
+
+        std::string_view name() const {
+            return _name;
+        }
+
+        void update() {
+            const auto &value = _generator();
+            std::string_view text(value);
+            for (auto &line : _lines) {
+                const auto eol = std::min(text.find('\n'), text.size());
+                align_to_width(line, text.substr(0, eol), W);
+                text.remove_prefix(std::min(text.size(), eol + 1));
+            }
+        }
+
+        void append_line(std::string &out, unsigned int line) const {
+            static const std::string style = Style::Default().to_string();
+            out += style;
+            out += _lines[line];
+        }
+    };
+
+    /**
+     * Same rendering as `ProgressCell`, on one line: `Generator` returns a percentage.
+     */
+    template<unsigned int W, class Generator>
+    class StaticProgressCell {
+        static constexpr bool print_percent = W > 7;
+        static constexpr unsigned int bar_width = (print_percent ? W - 4 : W);
+
+        std::string _name;
+        Generator _generator;
+        unsigned int _amount = 0;
+        std::array<char, 4> _percent{};
+
+      public:
+        static constexpr unsigned int width = W;
+        static constexpr unsigned int height = 1;
+
+        StaticProgressCell(std::string name, Generator generator) : _name(std::move(name)),
+            _generator(std::move(generator)) {}
+
+        std::string_view name() const {
+            return _name;
+        }
+
+        void update() {
+            const double progress = std::min(100.0, std::max(0.0, static_cast<double>(_generator())));
+            _amount = static_cast<unsigned int>(progress * bar_width / 100);
+            format_percent(_percent, std::trunc(progress));
+        }
+
+        void append_line(std::string &out, unsigned int) const {
+            static const std::string bar_style = Style(Color::Green).to_string();
+            static const std::string default_style = Style::Default().to_string();
+            static const std::string percent_style = Style(FontColor::Black, Font::Bold).to_string();
+
+            out += bar_style;
+            out.append(_amount, ' ');
+            out += default_style;
+            out.append(bar_width - _amount, ' ');
+            if constexpr (print_percent) {
+                out += percent_style;
+                out.append(_percent.data(), _percent.size());
+            }
+        }
+    };
+
+    template<unsigned int W, unsigned int H, class Generator>
+    StaticStringCell<W, H, Generator> static_string_cell(std::string name, Generator generator) {
+        return {std::move(name), std::move(generator)};
+    }
+
+    template<unsigned int W, class Generator>
+    StaticProgressCell<W, Generator> static_progress_cell(std::string name, Generator generator) {
+        return {std::move(name), std::move(generator)};
+    }
+
+    /**
+     * Dashboard whose cells are fixed at compile time: no virtual call nor `std::function` per frame.
+     * The cells are placed like in a `VirtualTerminal` once, at construction; the borders and names are then kept as
+     * constant text between the lines of the cells, so that composing a frame only appends strings.
+     */
+    template<StaticCell... Cells>
+    class StaticTerminal {
+        static constexpr unsigned int end_of_frame = std::numeric_limits<unsigned int>::max();
+
+        // `text` is written before the line `line` of the cell `cell`
+        struct Segment {
+            std::string text;
+            unsigned int cell;
+            unsigned int line;
+        };
+
+        // Stands for a cell during the placement, its lines are markers giving their positions in the frame
+        class Placeholder final : public AbstractCell {
+            unsigned int _index;
+
+          public:
+            Placeholder(unsigned int width, unsigned int height, unsigned int index) :
+                AbstractCell(width, height), _index(index) {}
+
+            void update() override {
+                _data.clear();
+                for (unsigned int i = 0; i < _height; ++i) {
+                    _data.emplace_back(Style::None(), '\x01' + std::to_string(_index) + ',' + std::to_string(i) + '\x02');
+                }
+            }
+        };
+
+        unsigned int _width;
+        unsigned int _height;
+        std::tuple<Cells...> _cells;
+        std::vector<Segment> _segments;
+        std::string _buffer;
+        std::string _next;
+        std::mutex _presenting;
+
+        const std::string _HIDE = "\e[0;8m";
+
+        template<std::size_t... I>
+        void update_cells(std::index_sequence<I...>) {
+            (std::get<I>(_cells).update(), ...);
+        }
+
+        template<std::size_t... I>
+        void append_line(std::string &out, unsigned int cell, unsigned int line, std::index_sequence<I...>) const {
+            ((cell == I ? std::get<I>(_cells).append_line(out, line) : void()), ...);
+        }
+
+        template<std::size_t... I>
+        void place(Layout &layout, std::index_sequence<I...>) {
+            (layout.add_cell(std::make_shared<Placeholder>(std::tuple_element_t<I, std::tuple<Cells...>>::width,
+                             std::tuple_element_t<I, std::tuple<Cells...>>::height, static_cast<unsigned int>(I)),
+                             std::string(std::get<I>(_cells).name())), ...);
+        }
+
+        void build_segments() {
+            Layout layout(_width, _height);
+            place(layout, std::index_sequence_for<Cells...> {});
+            layout.update(AbstractCell::Clock::now());
+
+            std::string frame;
+            layout.compose(frame);
+
+            std::string text;
+            for (std::size_t i = 0; i < frame.size(); ++i) {
+                if (frame[i] == '\x01') {
+                    const auto end = frame.find('\x02', i);
+                    const auto comma = frame.find(',', i);
+                    _segments.push_back({std::move(text),
+                                         static_cast<unsigned int>(std::stoul(frame.substr(i + 1, comma - i - 1))),
+                                         static_cast<unsigned int>(std::stoul(frame.substr(comma + 1, end - comma - 1)))
+                                        });
+                    text.clear();
+                    i = end;
+                } else {
+                    text += frame[i];
+                }
+            }
+            _segments.push_back({std::move(text), end_of_frame, 0});
+        }
+
+      public:
+        /**
+         * Throws if the cells don't fit in `max_width` x `max_height`.
+         */
+        StaticTerminal(unsigned int max_width, unsigned int max_height, Cells... cells) : _width(max_width),
+            _height(max_height), _cells(std::move(cells)...) {
+            build_segments();
+        }
+
+        template<std::size_t I>
+        auto &get() {
+            return std::get<I>(_cells);
+        }
+
+        /**
+         * Update the cells and compose the frame in `frame`, reusing its storage.
+         */
+        void render(std::string &frame) {
+            update_cells(std::index_sequence_for<Cells...> {});
+
+            frame.clear();
+            for (const auto &segment : _segments) {
+                frame += segment.text;
+                if (segment.cell != end_of_frame) {
+                    append_line(frame, segment.cell, segment.line, std::index_sequence_for<Cells...> {});
+                }
+            }
+        }
+
+        void print() {
+            std::lock_guard<std::mutex> lock(_presenting);
+
+            winsize size{};
+            ioctl(STDOUT_FILENO, TIOCGWINSZ, &size);
+            if (size.ws_col < _width || size.ws_row < _height) {
+                write_fully(STDOUT_FILENO, clear_lines(2) + "\e[0m" + Style(Font::Bold).to_string() +
+                            "Your terminal is too small to display the UI.\nPlease resize terminal window to at least " +
+                            std::to_string(_width) + "x" + std::to_string(_height) + ".\n");
+                _buffer = "\n\n";
+                return;
+            }
+
+            render(_next);
+            if (_next == _buffer) {
+                return;
+            }
+
+            std::string frame = begin_synchronized_update();
+            if (!_buffer.empty()) {
+                frame += clear_lines(std::count(_buffer.cbegin(), _buffer.cend(), '\n')) + "\e[0m";
+            }
+            frame += _next + _HIDE + end_synchronized_update();
+            std::swap(_buffer, _next);
+            write_fully(STDOUT_FILENO, frame);
+        }
+    };
+}
+
+#endif //AWESOME_VIEWER_STATICTERMINAL_H
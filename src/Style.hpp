@@ -5,6 +5,7 @@
 #ifndef AWESOME_VIEWER_STYLE_H
 #define AWESOME_VIEWER_STYLE_H
 
+#include <algorithm>
 #include <string>
 
 namespace AwesomeViewer {
@@ -57,6 +58,11 @@ namespace AwesomeViewer {
         Inherit = 11
     };
 
+    // One of the 256 colours of the terminals supporting them: 16 + 36 * r + 6 * g + b for r, g, b in [0, 5]
+    struct IndexedColor {
+        unsigned char index;
+    };
+
     template<class X>
     constexpr auto compose_mod(X x) {
         return x;
@@ -140,6 +146,8 @@ namespace AwesomeViewer {
         Color bg;
         FontColor fg;
         Font font;
+        // Replaces `bg` when set, see `with_background`
+        int bg_index = -1;
 
         template<class...Styles>
         constexpr Style(
@@ -155,6 +163,12 @@ namespace AwesomeViewer {
             return {Font::Default};
         }
 
+        constexpr Style with_background(IndexedColor color) const {
+            Style result = *this;
+            result.bg_index = color.index;
+            return result;
+        }
+
         inline string default_mod() const {
             return has(font, Font::Default) ? "0" : "";
         }
@@ -185,6 +199,9 @@ namespace AwesomeViewer {
 
 
         inline string bg_mod() const {
+            if (bg_index >= 0) {
+                return "48;5;" + std::to_string(bg_index);
+            }
             return (static_cast<int>(bg) < 11) ? std::to_string(40 + static_cast<int>(bg) - 1) : "";
         }
 
@@ -6,12 +6,15 @@
 #define AWESOME_VIEWER_STYLESTRING_H
 
 #include "Style.hpp"
+#include "Width.hpp"
 
 #include <algorithm>
+#include <cstdint>
 #include <string>
 #include <utility>
 #include <deque>
 #include <stdexcept>
+#include <vector>
 
 namespace AwesomeViewer {
 
@@ -30,8 +33,22 @@ namespace AwesomeViewer {
 
         inline std::string to_string() const {
             std::string result;
+            append_to(result);
+            return result;
+        }
+
+        inline void append_to(std::string &out) const {
             for (const auto &p : _data) {
-                result += p.first.to_string() + p.second;
+                out += p.first.to_string();
+                out += p.second;
+            }
+        }
+
+        // The text without any style
+        inline std::string to_plain_string() const {
+            std::string result;
+            for (const auto &p : _data) {
+                result += p.second;
             }
             return result;
         }
@@ -44,32 +61,91 @@ namespace AwesomeViewer {
             return size;
         }
 
-        StyleString substr(std::size_t begin_pos, std::size_t end_pos = std::string::npos) const {
-            StyleString copy = *this;
+        // Number of columns taken in a terminal, which differs from `size()` for non-ASCII text
+        inline std::size_t width() const {
+            std::size_t width = 0;
+            for (const auto &p : _data) {
+                width += display_width(p.second);
+            }
+            return width;
+        }
 
-            while (begin_pos > 0) {
-                auto size = copy._data.front().second.size();
-                if (size >= begin_pos) {
-                    copy._data[0].second = copy._data.front().second.substr(begin_pos);
-                    begin_pos = 0;
-                } else {
-                    copy._data.pop_front();
-                    begin_pos -= size;
+        // Longest prefix taking at most `max_width` columns, without cutting a character
+        StyleString prefix_of_width(std::size_t max_width) const {
+            StyleString result;
+            for (const auto &p : _data) {
+                const auto prefix = AwesomeViewer::prefix_of_width(p.second, max_width);
+                result._data.emplace_back(p.first, p.second.substr(0, prefix.bytes));
+                max_width -= prefix.width;
+                if (prefix.bytes < p.second.size()) {
+                    break;
                 }
             }
+            return result;
+        }
 
-            if (end_pos != std::string::npos) {
-                std::size_t count = 0;
-                for (std::size_t i = 0; i < copy._data.size(); ++i) {
-                    // need to truncate
-                    if (count + copy._data[i].second.size() > end_pos) {
-                        copy._data[i].second = copy._data[i].second.substr(0, end_pos - count);
-                        copy._data.resize(i + 1);
+        // At most `count` characters from `begin_pos`, only the overlapping parts are copied
+        StyleString substr(std::size_t begin_pos, std::size_t count = std::string::npos) const {
+            StyleString result;
+            std::size_t position = 0;
+            for (const auto &p : _data) {
+                const auto size = p.second.size();
+                if (position + size > begin_pos) {
+                    const auto first = std::max(begin_pos, position) - position;
+                    const auto n = std::min(size - first, count);
+                    result._data.emplace_back(p.first, p.second.substr(first, n));
+                    count -= n;
+                    if (count == 0) {
                         break;
                     }
                 }
+                position += size;
+            }
+            if (result._data.empty() && !_data.empty()) {
+                result._data.emplace_back(_data.back().first, std::string());
+            }
+            return result;
+        }
+
+        /**
+         * Split on '\n' in a single pass, the styles are kept: "a\nb" -> {"a", "b"}, "a\n" -> {"a", ""}.
+         */
+        std::vector<StyleString> split_lines() const {
+            std::vector<StyleString> lines;
+            if (_data.empty()) {
+                return lines;
+            }
+            lines.emplace_back();
+            for (const auto &p : _data) {
+                std::size_t begin = 0;
+                for (auto eol = p.second.find('\n'); eol != std::string::npos; eol = p.second.find('\n', begin)) {
+                    lines.back()._data.emplace_back(p.first, p.second.substr(begin, eol - begin));
+                    lines.emplace_back();
+                    begin = eol + 1;
+                }
+                lines.back()._data.emplace_back(p.first, p.second.substr(begin));
+            }
+            return lines;
+        }
+
+        // FNV-1a of the text and of the styles, to detect a change without keeping a copy
+        std::uint64_t hash(std::uint64_t seed = 14695981039346656037ull) const {
+            auto mix = [&seed](unsigned char byte) {
+                seed = (seed ^ byte) * 1099511628211ull;
+            };
+            for (const auto &p : _data) {
+                mix(static_cast<unsigned char>(p.first.bg));
+                mix(static_cast<unsigned char>(p.first.fg));
+                mix(static_cast<unsigned char>(static_cast<int>(p.first.font)));
+                mix(static_cast<unsigned char>(static_cast<int>(p.first.font) >> 8));
+                mix(static_cast<unsigned char>(p.first.bg_index));
+                for (char c : p.second) {
+                    mix(static_cast<unsigned char>(c));
+                }
+                // Separates "ab" + "c" from "a" + "bc" with the same styles
+                mix(0xff);
             }
-            return std::move(copy);
+            return seed;
         }
 
         inline StyleString &operator+=(const std::string &str) {
@@ -105,6 +181,11 @@ namespace AwesomeViewer {
             }
         }
 
+        // The text of each style, in order
+        inline const std::deque<std::pair<Style, std::string>> &segments() const {
+            return _data;
+        }
+
         inline bool empty() const {
             return _data.empty();
         }
@@ -0,0 +1,235 @@
+//
+// Created by terae on 19/10/26.
+//
+
+#ifndef AWESOME_VIEWER_TASKPROGRESSCELL_H
+#define AWESOME_VIEWER_TASKPROGRESSCELL_H
+
+#include "Cell.hpp"
+#include "Format.hpp"
+#include "utils.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace AwesomeViewer {
+
+    /**
+     * Progress of many tasks, e.g. the shards of a batch job. Each task has its own cache line: the producers only
+     * pay a relaxed increment, the totals are aggregated by the viewer at frame time.
+     */
+    class TaskSet {
+        struct alignas(64) Task {
+            std::atomic<std::uint64_t> done{0};
+            std::atomic<std::uint64_t> total{0};
+        };
+
+        std::size_t _count;
+        std::unique_ptr<Task[]> _tasks;
+
+      public:
+        TaskSet(std::size_t count, std::uint64_t total_per_task) : _count(count),
+            _tasks(std::make_unique<Task[]>(count)) {
+            for (std::size_t i = 0; i < _count; ++i) {
+                _tasks[i].total.store(total_per_task, std::memory_order_relaxed);
+            }
+        }
+
+        explicit TaskSet(const std::vector<std::uint64_t> &totals) : TaskSet(totals.size(), 0) {
+            for (std::size_t i = 0; i < _count; ++i) {
+                _tasks[i].total.store(totals[i], std::memory_order_relaxed);
+            }
+        }
+
+        std::size_t size() const {
+            return _count;
+        }
+
+        inline void advance(std::size_t task, std::uint64_t n = 1) {
+            _tasks[task].done.fetch_add(n, std::memory_order_relaxed);
+        }
+
+        inline void set_done(std::size_t task, std::uint64_t done) {
+            _tasks[task].done.store(done, std::memory_order_relaxed);
+        }
+
+        inline void set_total(std::size_t task, std::uint64_t total) {
+            _tasks[task].total.store(total, std::memory_order_relaxed);
+        }
+
+        std::uint64_t done(std::size_t task) const {
+            return _tasks[task].done.load(std::memory_order_relaxed);
+        }
+
+        std::uint64_t total(std::size_t task) const {
+            return _tasks[task].total.load(std::memory_order_relaxed);
+        }
+    };
+
+    class TaskProgressCell final : public AbstractCell {
+      public:
+        using Clock = std::chrono::steady_clock;
+
+      private:
+        // Time constant of the throughput average, in seconds
+        static constexpr double _window = 10.0;
+
+        const TaskSet &_tasks;
+        // "#" and the digits of the last index, followed by a space
+        unsigned int _label_width;
+        // Fraction done and index of the unfinished tasks, reused by each frame
+        std::vector<std::pair<double, std::size_t>> _unfinished;
+
+        std::uint64_t _done = 0;
+        std::uint64_t _total = 0;
+        std::size_t _finished = 0;
+        double _throughput = 0.0;
+
+        bool _started = false;
+        std::uint64_t _first_done = 0;
+        Clock::time_point _start;
+        Clock::time_point _last_sample;
+        std::uint64_t _last_done = 0;
+
+        void sample(Clock::time_point now) {
+            if (!_started) {
+                _started = true;
+                _first_done = _last_done = _done;
+                _start = _last_sample = now;
+                return;
+            }
+
+            const double elapsed = std::chrono::duration<double>(now - _last_sample).count();
+            if (elapsed < 1e-3) {
+                return;
+            }
+            const double lifetime = std::chrono::duration<double>(now - _start).count();
+            const double instant = static_cast<double>(_done - std::min(_done, _last_done)) / elapsed;
+            if (lifetime < _window) {
+                // Not enough history yet: plain average since the first sample
+                _throughput = static_cast<double>(_done - std::min(_done, _first_done)) / lifetime;
+            } else {
+                _throughput += (1.0 - std::exp(-elapsed / _window)) * (instant - _throughput);
+            }
+            _last_done = _done;
+            _last_sample = now;
+        }
+
+        std::string summary_line() const {
+            std::string line(_width, ' ');
+            Chars chars;
+            chars.append_number(_finished);
+            chars.append('/');
+            chars.append_number(_tasks.size());
+            chars.append(" tasks");
+            format_aligned(std::span<char>(line).first(std::min<std::size_t>(_width, 16)), chars.view());
+
+            if (_width >= 42) {
+                format_rate(std::span<char>(line).subspan(16, 12), _throughput);
+                const double remaining = static_cast<double>(_total - std::min(_total, _done));
+                auto eta = std::span<char>(line).subspan(30, 12);
+                if (remaining == 0.0) {
+                    format_aligned(eta, "done", Align::Right);
+                } else if (_throughput <= 0.0) {
+                    format_aligned(eta, "ETA -", Align::Right);
+                } else {
+                    format_duration(eta.subspan(4), std::chrono::duration<double>(remaining / _throughput));
+                    const auto begin = line.find_first_not_of(' ', 34);
+                    line.replace(begin - 4, 4, "ETA ");
+                }
+            }
+            return line;
+        }
+
+        StyleString bar_line(std::string label, double fraction) const {
+            const unsigned int label_width = std::min(_width, _label_width);
+            const unsigned int percent_width = (_width >= label_width + 10 ? 5 : 0);
+            label.resize(label_width, ' ');
+
+            std::string bar;
+            append_bar(bar, fraction, _width - label_width - percent_width);
+            std::string percent(percent_width, ' ');
+            format_percent(percent, std::floor(fraction * 100.0));
+
+            StyleString result;
+            result.insert(Style(FontColor::Black, Font::Bold), std::move(label));
+            result.insert(Style(FontColor::Green), std::move(bar));
+            result.insert(Style(FontColor::Black, Font::Bold), std::move(percent));
+            return result;
+        }
+
+      public:
+        /**
+         * The first line shows the progress of all the tasks, the second one the throughput and the ETA, the
+         * remaining lines the least advanced unfinished tasks.
+         */
+        TaskProgressCell(unsigned int width, unsigned int height, const TaskSet &tasks) :
+            AbstractCell(width, height), _tasks(tasks),
+            _label_width(static_cast<unsigned int>(std::max<std::size_t>(3, std::to_string(tasks.size()).size() + 1)) + 1) {}
+
+        ~TaskProgressCell() override = default;
+
+        const char *get_type() const override {
+            return "tasks";
+        }
+
+        void export_to(Exporter &exporter) const override {
+            exporter.field("done", static_cast<double>(_done));
+            exporter.field("total", static_cast<double>(_total));
+            exporter.field("finished", static_cast<double>(_finished));
+            exporter.field("tasks", static_cast<double>(_tasks.size()));
+            exporter.field("throughput", _throughput);
+        }
+
+        void update() override {
+            update(Clock::now());
+        }
+
+        // Sample the throughput as if it was `now`, which never goes back
+        void update(Clock::time_point now) {
+            _done = _total = 0;
+            _finished = 0;
+            _unfinished.clear();
+            for (std::size_t i = 0; i < _tasks.size(); ++i) {
+                const auto total = _tasks.total(i);
+                const auto done = std::min(_tasks.done(i), total);
+                _done += done;
+                _total += total;
+                if (done == total) {
+                    ++_finished;
+                } else {
+                    _unfinished.emplace_back(static_cast<double>(done) / static_cast<double>(total), i);
+                }
+            }
+            sample(now);
+
+            _data.clear();
+            std::string label = "all";
+            _data.push_back(bar_line(label, _total == 0 ? 1.0 : static_cast<double>(_done) / static_cast<double>(_total)));
+            if (_height > 1) {
+                _data.emplace_back(Style::Default(), summary_line());
+            }
+
+            const auto slowest = std::min<std::size_t>(_height > 2 ? _height - 2 : 0, _unfinished.size());
+            std::partial_sort(_unfinished.begin(), _unfinished.begin() + static_cast<long>(slowest), _unfinished.end());
+            for (std::size_t i = 0; i < slowest; ++i) {
+                label = '#';
+                label += std::to_string(_unfinished[i].second);
+                _data.push_back(bar_line(label, _unfinished[i].first));
+            }
+
+            while (_data.size() < _height) {
+                _data.emplace_back(Style::Default(), std::string(_width, ' '));
+            }
+        }
+    };
+}
+
+#endif //AWESOME_VIEWER_TASKPROGRESSCELL_H
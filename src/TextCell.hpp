@@ -0,0 +1,246 @@
+//
+// Created by terae on 19/10/26.
+//
+
+#ifndef AWESOME_VIEWER_TEXTCELL_H
+#define AWESOME_VIEWER_TEXTCELL_H
+
+#include "Cell.hpp"
+#include "Width.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace AwesomeViewer {
+
+    /**
+     * Append-only text stored in fixed-size chunks, which are never moved nor copied once written, with the offset
+     * of each line. Finding the chunk of an offset is a binary search over the chunks.
+     */
+    class TextBuffer {
+      public:
+        static constexpr std::size_t chunk_size = std::size_t(1) << 16;
+
+      private:
+        std::vector<std::unique_ptr<std::string>> _chunks;
+        // Offset of the first character of each chunk and of each line
+        std::vector<std::size_t> _chunk_offsets;
+        std::vector<std::size_t> _line_offsets = {0};
+        std::size_t _size = 0;
+
+      public:
+        std::size_t size() const {
+            return _size;
+        }
+
+        // A final '\n' doesn't start a new line
+        std::size_t line_count() const {
+            return _line_offsets.size() - (_size > 0 && _line_offsets.back() == _size ? 1 : 0);
+        }
+
+        void append(std::string_view text) {
+            while (!text.empty()) {
+                if (_chunks.empty() || _chunks.back()->size() == chunk_size) {
+                    _chunks.push_back(std::make_unique<std::string>());
+                    _chunks.back()->reserve(chunk_size);
+                    _chunk_offsets.push_back(_size);
+                }
+                auto &chunk = *_chunks.back();
+                const auto piece = text.substr(0, chunk_size - chunk.size());
+                for (auto eol = piece.find('\n'); eol != std::string_view::npos; eol = piece.find('\n', eol + 1)) {
+                    _line_offsets.push_back(_size + eol + 1);
+                }
+                chunk.append(piece);
+                _size += piece.size();
+                text.remove_prefix(piece.size());
+            }
+        }
+
+        void clear() {
+            _chunks.clear();
+            _chunk_offsets.clear();
+            _line_offsets = {0};
+            _size = 0;
+        }
+
+        /**
+         * Replace `out` by at most `max_size` bytes of the line `line`, without its '\n' and without cutting a UTF-8
+         * character.
+         */
+        void copy_line(std::size_t line, std::size_t max_size, std::string &out) const {
+            out.clear();
+            if (line >= _line_offsets.size()) {
+                return;
+            }
+            std::size_t begin = _line_offsets[line];
+            const std::size_t line_end = (line + 1 < _line_offsets.size() ? _line_offsets[line + 1] - 1 : _size);
+            const std::size_t end = std::min(line_end, begin + max_size);
+
+            auto chunk = static_cast<std::size_t>(std::upper_bound(_chunk_offsets.cbegin(), _chunk_offsets.cend(),
+                                                  begin) - _chunk_offsets.cbegin()) - 1;
+            while (begin < end) {
+                const auto offset = begin - _chunk_offsets[chunk];
+                const auto n = std::min(end - begin, _chunks[chunk]->size() - offset);
+                out.append(*_chunks[chunk], offset, n);
+                begin += n;
+                ++chunk;
+            }
+
+            if (end < line_end) {
+                // Drop the beginning of a truncated multi-byte character
+                auto lead = out.size();
+                while (lead > 0 && (static_cast<unsigned char>(out[lead - 1]) & 0xC0) == 0x80) {
+                    --lead;
+                }
+                if (lead > 0 && (static_cast<unsigned char>(out[lead - 1]) & 0x80)) {
+                    const auto c = static_cast<unsigned char>(out[lead - 1]);
+                    const std::size_t length = (c >= 0xF0 ? 4 : c >= 0xE0 ? 3 : 2);
+                    if (lead - 1 + length > out.size()) {
+                        out.resize(lead - 1);
+                    }
+                }
+            }
+        }
+    };
+
+    /**
+     * Scrollable view over a large text, e.g. a generated report or a log. Appending doesn't copy the existing text,
+     * and a frame only reads the visible lines: its cost doesn't depend on the size of the text.
+     * The text can be appended from any thread.
+     */
+    class TextCell final : public AbstractCell {
+        mutable std::mutex _mutex;
+        TextBuffer _text;
+        std::size_t _top = 0;
+        bool _follow;
+        // Changed by each modification, so that an unchanged window isn't copied again
+        std::uint64_t _version = 0;
+        std::uint64_t _rendered_version = 0;
+        std::string _line;
+
+        std::size_t last_top() const {
+            const auto count = _text.line_count();
+            return count > _height ? count - _height : 0;
+        }
+
+        // First displayed line, with the lock held
+        std::size_t displayed_top() const {
+            return _follow ? last_top() : std::min(_top, last_top());
+        }
+
+        // Copy the displayed lines into `_data`, with the lock held
+        void copy_window() {
+            _rendered_version = _version;
+
+            const auto top = displayed_top();
+            _data.clear();
+            for (std::size_t i = 0; i < _height; ++i) {
+                // At most 4 bytes per column, cut to the width of the cell once decoded
+                _text.copy_line(top + i, 4 * static_cast<std::size_t>(_width), _line);
+                if (!_line.empty() && _line.back() == '\r') {
+                    _line.pop_back();
+                }
+                const auto prefix = prefix_of_width(_line, _width);
+                _line.resize(prefix.bytes);
+                _line.append(_width - prefix.width, ' ');
+                _data.emplace_back(Style::Default(), _line);
+            }
+        }
+
+      public:
+        /**
+         * With `follow`, the last lines are displayed, as with `tail -f`, until the text is scrolled.
+         */
+        TextCell(unsigned int width, unsigned int height, bool follow = true) : AbstractCell(width, height),
+            _follow(follow) {}
+
+        ~TextCell() override = default;
+
+        const char *get_type() const override {
+            return "text";
+        }
+
+        void append(std::string_view text) {
+            std::lock_guard<std::mutex> lock(_mutex);
+            const auto top = displayed_top();
+            // The last line may be continued by `text`
+            const auto first_changed = _text.line_count() - 1;
+            _text.append(text);
+            // Below the displayed lines, the window doesn't change
+            if (_follow || displayed_top() != top || first_changed < top + _height) {
+                ++_version;
+            }
+        }
+
+        void clear() {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _text.clear();
+            _top = 0;
+            ++_version;
+        }
+
+        std::size_t line_count() const {
+            std::lock_guard<std::mutex> lock(_mutex);
+            return _text.line_count();
+        }
+
+        // First displayed line
+        std::size_t top_line() const {
+            std::lock_guard<std::mutex> lock(_mutex);
+            return displayed_top();
+        }
+
+        void scroll_to(std::size_t line) {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _follow = false;
+            _top = std::min(line, last_top());
+            ++_version;
+        }
+
+        // Scroll by `lines`, up if negative; scrolling down to the end follows the text again
+        void scroll(long lines) override {
+            std::lock_guard<std::mutex> lock(_mutex);
+            const auto top = static_cast<long>(displayed_top());
+            _top = static_cast<std::size_t>(std::max(0l, top + lines));
+            _follow = _top >= last_top();
+            ++_version;
+            if (!_data.empty()) {
+                // Displayed at once, without waiting for the next update
+                copy_window();
+            }
+        }
+
+        // The restored lines aren't a window of the text: the first update copies one
+        void restore_lines(std::vector<StyleString> lines) override {
+            std::lock_guard<std::mutex> lock(_mutex);
+            AbstractCell::restore_lines(std::move(lines));
+            ++_version;
+        }
+
+        void set_follow(bool follow) {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _follow = follow;
+            ++_version;
+        }
+
+        bool is_following() const {
+            std::lock_guard<std::mutex> lock(_mutex);
+            return _follow;
+        }
+
+        void update() override {
+            std::lock_guard<std::mutex> lock(_mutex);
+            if (!_data.empty() && _rendered_version == _version) {
+                return;
+            }
+            copy_window();
+        }
+    };
+}
+
+#endif //AWESOME_VIEWER_TEXTCELL_H
@@ -6,14 +6,25 @@
 #define AWESOME_VIEWER_VIRTUALTERMINAL_H
 
 #include "Cell.hpp"
+#include "DashboardState.hpp"
+#include "Executor.hpp"
+#include "Export.hpp"
+#include "Keyboard.hpp"
+#include "Layout.hpp"
 #include "Pixel.hpp"
 #include "utils.hpp"
+#include "Width.hpp"
 
 #include <algorithm>
+#include <atomic>
 #include <chrono>
+#include <cstdint>
 #include <iostream>
 #include <limits>
+#include <map>
 #include <memory>
+#include <mutex>
+#include <sstream>
 #include <sys/ioctl.h>
 #include <stdio.h>
 #include <thread>
@@ -21,196 +32,849 @@
 
 namespace AwesomeViewer {
 
+    enum class Presentation {
+        // Redraw in place, below the current line
+        Inline,
+        // Full-screen on the alternate screen, restored when the terminal is destroyed
+        AlternateScreen,
+        // For pipes and logs: the displayed page as plain text, when it changed
+        Snapshot,
+        // For pipes and logs: the values of the cells of the displayed page which changed, as logfmt lines
+        Changes
+    };
+
+    struct FrameStatistics {
+        std::uint64_t frames;
+        // Frames in which some cells weren't updated because of the frame budget
+        std::uint64_t degraded_frames;
+        std::uint64_t skipped_updates;
+    };
+
     class VirtualTerminal {
         unsigned int _width;
         unsigned int _height;
 
         std::string _buffer;
+        // Next frame, composed in the storage of the frame before the previous one
+        std::string _next;
+        // Escape sequences written for the last frame, their storage is reused
+        std::string _output;
+
+        struct Page {
+            std::string name;
+            std::shared_ptr<const Layout> layout;
+        };
+
+        using Pages = std::vector<Page>;
 
-        std::vector<std::vector<std::unique_ptr<AbstractPixel>>> _pixels;
+        // Immutable snapshot read by the frames, replaced as a whole by the writers
+        std::atomic<std::shared_ptr<const Pages>> _pages;
+        std::mutex _writer;
+        std::atomic<std::size_t> _current_page{0};
+        std::mutex _presenting;
+
+        class Reading;
+        // Thread holding `_presenting` while it reads the pages, and its `Reading`, only used by this thread
+        std::atomic<std::thread::id> _rendering_thread;
+        Reading *_reading = nullptr;
+        // Incremented at the beginning and at the end of each `Reading`: odd while the pages are read
+        std::atomic<std::uint64_t> _readings{0};
 
         const std::string _HIDE = "\e[0;8m";
 
-        struct Coord {
-            unsigned int x, y;
+        Presentation _presentation = Presentation::Inline;
+        bool _synchronized = true;
+        bool _entered_alternate_screen = false;
+
+        std::chrono::steady_clock::duration _snapshot_interval = std::chrono::seconds(1);
+        std::chrono::steady_clock::time_point _last_snapshot{};
+        // Values last written by `Changes` for each cell, erased by `remove_cell`
+        std::map<const AbstractCell *, std::vector<std::pair<std::string, std::string>>> _last_values;
+        std::mutex _logging;
+
+        std::chrono::nanoseconds _frame_budget = std::chrono::nanoseconds::zero();
+        std::atomic<std::uint64_t> _frames{0};
+        std::atomic<std::uint64_t> _degraded_frames{0};
+        std::atomic<std::uint64_t> _skipped_updates{0};
+
+        Executor _executor;
+
+        std::unique_ptr<ExportServer> _server;
+        ExportFormat _server_format = ExportFormat::Json;
+
+        // Created by the first `wait_for`
+        std::unique_ptr<Keyboard> _keyboard;
+        // Whether `_buffer` is the frame on the screen, which a partial redraw can be written over
+        bool _frame_displayed = false;
+
+        // Cells of the previous run not added back yet, protected by `_writer`
+        std::vector<SavedPage> _restored;
+
+        /**
+         * Copy the pages, let `modify` change the copy and publish it. Return the previous snapshot.
+         */
+        template<class F>
+        std::shared_ptr<const Pages> publish(F &&modify) {
+            std::lock_guard<std::mutex> lock(_writer);
+            auto pages = std::make_shared<Pages>(*_pages.load());
+            modify(*pages);
+            return _pages.exchange(std::move(pages));
+        }
 
-            friend bool operator==(const Coord &c1, const Coord &c2) {
-                return c1.x == c2.x && c1.y == c2.y;
+        /**
+         * Pages read under `_presenting` by a frame or a key, which may call the code of the cells. A cell removed by
+         * this code isn't used by the reading anymore once `remove_cell` returns: the updates stop, and the rest of
+         * the reading uses the pages published without the cell, while the previous ones are kept alive until its end.
+         */
+        class Reading {
+            VirtualTerminal &_terminal;
+            std::shared_ptr<const Pages> _read;
+            std::shared_ptr<const Pages> _latest;
+            FrameBudget *_budget = nullptr;
+
+          public:
+            // The pages are loaded once the reading is counted: see `synchronize`
+            explicit Reading(VirtualTerminal &terminal) : _terminal(terminal) {
+                _terminal._readings.fetch_add(1);
+                _read = _terminal._pages.load();
+                _terminal._reading = this;
+                _terminal._rendering_thread = std::this_thread::get_id();
             }
 
-            friend std::ostream &operator<<(std::ostream &os, const Coord &c) {
-                return os << '[' << c.x << ',' << c.y << ']';
+            Reading(const Reading &) = delete;
+            Reading &operator=(const Reading &) = delete;
+
+            ~Reading() {
+                _terminal._rendering_thread = std::thread::id();
+                _terminal._reading = nullptr;
+                _terminal._readings.fetch_add(1);
+                _terminal._readings.notify_all();
+            }
+
+            const Pages &pages() const {
+                return _latest ? *_latest : *_read;
             }
-        };
 
-        const Coord out_of_space = {std::numeric_limits<unsigned int>::max(), std::numeric_limits<unsigned int>::max()};
+            // Cancelled by a removal
+            void watch(FrameBudget &budget) {
+                _budget = &budget;
+            }
 
-        Coord get_free_space(const AbstractCell &cell) const {
-            bool found = false;
-            Coord result{std::numeric_limits<unsigned int>::max(), std::numeric_limits<unsigned int>::max()};
-            for (unsigned int y = 0; y < _height - cell.get_height() && !found; ++y) {
-                for (unsigned int x = 0; x < _width - cell.get_width() && !found; ++x) {
-                    bool interesting_cell = _pixels[y][x] == nullptr;
-                    if (!interesting_cell) {
-                        interesting_cell = _pixels[y][x]->can_be_overwritten();
-                    }
+            void replace(std::shared_ptr<const Pages> latest) {
+                _latest = std::move(latest);
+                if (_budget != nullptr) {
+                    _budget->cancel();
+                }
+            }
+        };
 
-                    if (interesting_cell) {
-                        bool is_ok = true;
-                        for (unsigned int Y = y; Y < y + cell.get_height() + 2 && is_ok; ++Y) {
-                            for (unsigned int X = x; X < x + cell.get_width() + 4 && is_ok; ++X) {
-                                if (_pixels[Y][X] != nullptr) {
-                                    if (!_pixels[Y][X]->can_be_overwritten()) {
-                                        is_ok = false;
-                                    }
-                                }
-                            }
-                        }
-                        if (is_ok) {
-                            found = true;
-                            result = {x, y};
-                        }
+        /**
+         * Wait for the end of the reading begun before pages were published, if any: the next ones load the published
+         * pages. Called during a reading by the same thread, e.g. from the update of a cell, this reading switches to
+         * the published pages instead.
+         */
+        void synchronize() {
+            if (_rendering_thread.load() == std::this_thread::get_id()) {
+                _reading->replace(_pages.load());
+                return;
+            }
+            // The readings are serialised by `_presenting`: at most one of them is in progress
+            const auto readings = _readings.load();
+            if (readings % 2 == 1) {
+                _readings.wait(readings);
+            }
+        }
+
+        // Publish copies of the layouts highlighting the name of `cell`: a published layout is never changed
+        void highlight(const AbstractCell *cell) {
+            publish([cell](Pages & pages) {
+                for (auto &page : pages) {
+                    if (page.layout->get_focus() != cell) {
+                        auto layout = std::make_shared<Layout>(*page.layout);
+                        layout->set_focus(cell);
+                        page.layout = std::move(layout);
                     }
                 }
+            });
+        }
+
+        static std::string export_pages(const Pages &pages, ExportFormat format) {
+            auto exporter = make_exporter(format);
+            export_pages(pages, *exporter);
+            return exporter->finish();
+        }
+
+        // Only the cells having been updated at least once are exported
+        static void export_pages(const Pages &pages, Exporter &exporter) {
+            for (const auto &page : pages) {
+                export_page(page, exporter, [](const AbstractCell &) {});
             }
-            return result;
         }
 
-        void insert_border(const Coord &coords, PixelType border) {
-            if (_pixels[coords.y][coords.x] == nullptr) {
-                _pixels[coords.y][coords.x] = std::make_unique<BorderPixel>(border);
-            } else {
-                try {
-                    auto &pixel = dynamic_cast<BorderPixel &>(*_pixels[coords.y][coords.x]);
-                    pixel.update_border_type(border);
-                } catch (std::bad_cast &) {
-                    std::stringstream what;
-                    what << "The pixel " << coords << " isn't a border.";
-                    throw std::runtime_error(what.str());
+        // `exported` is called with each cell once it is exported
+        template<class F>
+        static void export_page(const Page &page, Exporter &exporter, F &&exported) {
+            std::size_t index = 0;
+            page.layout->for_each_cell([&](const std::string & name, const AbstractCell & cell) {
+                ++index;
+                if (cell.has_data()) {
+                    exporter.begin_cell(page.name, name.empty() ? "cell" + std::to_string(index) : name,
+                                        cell.get_type());
+                    cell.export_to(exporter);
+                    exporter.end_cell();
+                    exported(cell);
+                }
+            });
+        }
+
+        // One line listing the pages, only displayed when there are several ones
+        void compose_tabs(std::string &next, const Pages &pages, std::size_t current) const {
+            unsigned int remaining = _width;
+            for (std::size_t i = 0; i < pages.size() && remaining > 0; ++i) {
+                std::string tab = ' ' + std::to_string(i + 1) + ' ' + pages[i].name + ' ';
+                const auto prefix = prefix_of_width(tab, remaining);
+                tab.resize(prefix.bytes);
+                remaining -= static_cast<unsigned int>(prefix.width);
+
+                if (i == current) {
+                    next += Style(Font::Bold, FontColor::Black, Color::Cyan).to_string();
+                } else {
+                    next += Style(FontColor::Cyan).to_string();
                 }
+                next += tab;
+                next += "\e[0m";
             }
+            next += std::string(remaining, ' ');
+            next += '\n';
+        }
+
+        static unsigned int get_tabs_height(const Pages &pages) {
+            return pages.size() > 1 ? 1 : 0;
         }
 
       public:
+        /**
+         * When the standard output isn't a terminal, the presentation is `Changes`.
+         */
         VirtualTerminal(unsigned int max_width, unsigned int max_height) : _width(max_width), _height(max_height) {
-            for (unsigned int y = 0; y < _height; ++y) {
-                std::vector<std::unique_ptr<AbstractPixel>> v;
-                for (unsigned int x = 0; x < _width; ++x) {
-                    v.emplace_back(nullptr);
-                }
-                _pixels.emplace_back(std::move(v));
+            if (!isatty(STDOUT_FILENO)) {
+                _presentation = Presentation::Changes;
             }
+            _pages.store(std::make_shared<const Pages>(Pages{{"Main", std::make_shared<const Layout>(_width, _height)}}));
+        }
+
+        ~VirtualTerminal() {
+            leave_presentation();
         }
 
-        void add_cell(AbstractCell &cell, const std::string &name = "") {
-            Coord space = get_free_space(cell);
-            if (space == out_of_space) {
-                throw std::runtime_error("No space left.");
+        Executor &executor() {
+            return _executor;
+        }
+
+        void set_presentation(Presentation presentation) {
+            std::lock_guard<std::mutex> lock(_presenting);
+            if (presentation != Presentation::AlternateScreen) {
+                leave_presentation();
             }
+            _presentation = presentation;
+            _buffer.clear();
+            _frame_displayed = false;
+        }
 
-            // Top border
-            unsigned int x = space.x;
-            unsigned int y = space.y;
-            insert_border({x++, y}, TopLeftCorner);
-            insert_border({x++, y}, HorizontalBorder);
+        /**
+         * Minimum delay between two outputs of the `Snapshot` and `Changes` presentations: the cells aren't updated
+         * in between.
+         */
+        void set_snapshot_interval(std::chrono::steady_clock::duration interval) {
+            std::lock_guard<std::mutex> lock(_presenting);
+            _snapshot_interval = interval;
+        }
 
-            if (name.empty()) {
-                for (unsigned int i = 0; i < cell.get_width() + 1; ++i) {
-                    insert_border({x++, y}, HorizontalBorder);
+        /**
+         * Wrap each frame in synchronized update markers (DEC private mode 2026), enabled by default: the terminal
+         * repaints once per frame. The terminals which don't support it ignore them.
+         */
+        void set_synchronized_output(bool synchronized) {
+            std::lock_guard<std::mutex> lock(_presenting);
+            _synchronized = synchronized;
+        }
+
+        /**
+         * Add an empty page, and return its index. Only the cells of the displayed page are updated.
+         */
+        std::size_t add_page(const std::string &name) {
+            std::size_t index = 0;
+            publish([&](Pages & pages) {
+                pages.push_back({name, std::make_shared<const Layout>(_width, _height)});
+                index = pages.size() - 1;
+            });
+            return index;
+        }
+
+        std::size_t page_count() const {
+            return _pages.load()->size();
+        }
+
+        std::size_t current_page() const {
+            return _current_page;
+        }
+
+        // Name given to `add_page`, "Main" for the first page
+        std::string page_name(std::size_t page) const {
+            auto pages = _pages.load();
+            if (page >= pages->size()) {
+                throw std::range_error("Page out of range.");
+            }
+            return (*pages)[page].name;
+        }
+
+        /**
+         * Display another page at once, from the last content of its cells: their generators are called at the next
+         * `print`.
+         */
+        void select_page(std::size_t page) {
+            if (page >= page_count()) {
+                throw std::range_error("Page out of range.");
+            }
+            if (_current_page.exchange(page) != page) {
+                present(false);
+            }
+        }
+
+        void select_page(const std::string &name) {
+            std::size_t index = 0;
+            {
+                auto pages = _pages.load();
+                auto it = std::find_if(pages->cbegin(), pages->cend(), [&name](const Page & page) {
+                    return page.name == name;
+                });
+                if (it == pages->cend()) {
+                    throw std::invalid_argument("No page named \"" + name + "\".");
                 }
+                index = static_cast<std::size_t>(it - pages->cbegin());
+            }
+            select_page(index);
+        }
+
+        void next_page() {
+            select_page((_current_page + 1) % page_count());
+        }
+
+        void previous_page() {
+            select_page((_current_page + page_count() - 1) % page_count());
+        }
+
+        /**
+         * Keys switching the pages: '1' to '9' select one, '[' and ']' the previous and the next one.
+         * Tab and Shift-Tab move the focus between the cells of the page; the arrows, 'j' and 'k', Page Up and Page
+         * Down scroll the focused cell, only redrawing it.
+         * Return false if the key isn't handled.
+         */
+        bool handle_key(int key) {
+            if (key >= '1' && key <= '9' && static_cast<std::size_t>(key - '1') < page_count()) {
+                select_page(static_cast<std::size_t>(key - '1'));
+            } else if (key == '[') {
+                previous_page();
+            } else if (key == ']') {
+                next_page();
+            } else if (key == '\t' || key == BackTab) {
+                move_focus(key == '\t' ? 1 : -1);
+            } else if (key == Up || key == 'k') {
+                scroll_focus(-1, false);
+            } else if (key == Down || key == 'j') {
+                scroll_focus(1, false);
+            } else if (key == PageUp) {
+                scroll_focus(-1, true);
+            } else if (key == PageDown) {
+                scroll_focus(1, true);
             } else {
-                insert_border({x++, y}, EmptyBorder);
+                return false;
+            }
+            return true;
+        }
 
-                std::string s = name.substr(0, static_cast<std::size_t>(std::max(static_cast<int>(cell.get_width()) - 2, 0)));
-                _pixels[y][x++] = std::make_unique<CellNamePixel>(s);
-                for (unsigned int i = 0; i < s.size() - 1; ++i) {
-                    _pixels[y][x++] = std::make_unique<EmptyPixel>();
+        /**
+         * Wait for `duration`, handling the keys as they are typed: see `handle_key`. The terminal is in raw mode
+         * from the first call until the destruction of the terminal. Only sleep if the standard input isn't a terminal.
+         */
+        void wait_for(std::chrono::steady_clock::duration duration) {
+            const auto deadline = std::chrono::steady_clock::now() + duration;
+            if (!_keyboard) {
+                _keyboard = std::make_unique<Keyboard>();
+            }
+            if (!_keyboard->is_enabled()) {
+                std::this_thread::sleep_until(deadline);
+                return;
+            }
+            for (auto now = std::chrono::steady_clock::now(); now < deadline; now = std::chrono::steady_clock::now()) {
+                const int key = _keyboard->read_key(std::chrono::ceil<std::chrono::milliseconds>(deadline - now));
+                if (key != NoKey) {
+                    handle_key(key);
                 }
+            }
+        }
 
-                insert_border({x++, y}, EmptyBorder);
+        // The focused cell of the displayed page, nullptr if none
+        const AbstractCell *focused_cell() const {
+            auto pages = _pages.load();
+            const auto &layout = *(*pages)[std::min<std::size_t>(_current_page, pages->size() - 1)].layout;
+            return layout.find_cell(layout.get_focus());
+        }
 
-                for (unsigned int i = 0; i < cell.get_width() - 1 - s.size(); ++i) {
-                    insert_border({x++, y}, HorizontalBorder);
+        /**
+         * Can be called from any thread: the frames keep displaying the previous layout until the new one is
+         * published, and then share the ownership of the cell.
+         */
+        void add_cell(std::shared_ptr<AbstractCell> cell, const std::string &name = "", std::size_t page = 0) {
+            publish([&](Pages & pages) {
+                if (page >= pages.size()) {
+                    throw std::range_error("Page out of range.");
                 }
+                auto layout = std::make_shared<Layout>(*pages[page].layout);
+                if (!restore_cell(*layout, pages[page].name, cell, name)) {
+                    layout->add_cell(std::move(cell), name);
+                }
+                pages[page].layout = std::move(layout);
+            });
+        }
+
+        /**
+         * `cell` isn't owned by the terminal: it must be removed with `remove_cell` before being destroyed.
+         */
+        void add_cell(AbstractCell &cell, const std::string &name = "", std::size_t page = 0) {
+            add_cell(std::shared_ptr<AbstractCell>(std::shared_ptr<AbstractCell>(), &cell), name, page);
+        }
+
+        /**
+         * Can be called from any thread. Once it returns, no frame uses the cell anymore: it can be destroyed.
+         * Return false if the cell wasn't displayed.
+         */
+        bool remove_cell(const AbstractCell &cell) {
+            bool found = false;
+            publish([&](Pages & pages) {
+                for (auto &page : pages) {
+                    auto layout = std::make_shared<Layout>(*page.layout);
+                    if (layout->remove_cell(cell)) {
+                        page.layout = std::move(layout);
+                        found = true;
+                    }
+                }
+            });
+            synchronize();
+            {
+                // The cell, or another one at the same address, is written as a whole if it is added again
+                std::lock_guard<std::mutex> lock(_logging);
+                _last_values.erase(&cell);
             }
+            return found;
+        }
 
-            insert_border({x, y++}, TopRightCorner);
+        /**
+         * Serialise the content of the cells as computed by the last frame.
+         */
+        std::string export_snapshot(ExportFormat format = ExportFormat::Json) {
+            std::lock_guard<std::mutex> lock(_presenting);
+            Reading reading(*this);
+            return export_pages(reading.pages(), format);
+        }
 
-            // Cell
-            for (unsigned int i = 0; i < cell.get_height(); ++i) {
-                x = space.x;
-                insert_border({x++, y}, VerticalBorder);
-                insert_border({x++, y}, EmptyBorder);
+        void export_to_file(const std::string &path, ExportFormat format = ExportFormat::Json) {
+            write_file_atomically(path, export_snapshot(format));
+        }
 
-                _pixels[y][x++] = std::make_unique<CellValuePixel>([&cell, i]() {
-                    if (i == 0) {
-                        cell.update();
-                    }
-                    return cell.get_nth_line(i);
+        /**
+         * Save the placement and the content of the cells, and the displayed frame, for `restore_state`.
+         */
+        void save_state(const std::string &path) {
+            std::lock_guard<std::mutex> lock(_presenting);
+            DashboardState state;
+            state.width = _width;
+            state.height = _height;
+            if (_frame_displayed) {
+                state.frame = _buffer;
+            }
+            Reading reading(*this);
+            for (const auto &page : reading.pages()) {
+                SavedPage saved{page.name, {}};
+                page.layout->for_each_placement([&saved](const std::string & name, const AbstractCell & cell,
+                unsigned int x, unsigned int y) {
+                    saved.cells.push_back({name, x, y, cell.get_width(), cell.get_height(), cell.get_lines()});
                 });
-                for (unsigned int j = 0; j < cell.get_width() - 1; ++j) {
-                    _pixels[y][x++] = std::make_unique<EmptyPixel>();
-                }
+                state.pages.push_back(std::move(saved));
+            }
+            write_file_atomically(path, state.serialize());
+        }
 
-                insert_border({x++, y}, EmptyBorder);
-                insert_border({x, y++}, VerticalBorder);
+        /**
+         * Load a state saved by `save_state` with the same terminal size, before adding the cells: the previous frame
+         * is displayed at once, and each cell added with the same name and size on a page of the same name is placed
+         * where it was and displays its previous content until its first update.
+         * Return false if there is no such state.
+         */
+        bool restore_state(const std::string &path) {
+            auto state = DashboardState::load(path);
+            if (!state || state->width != _width || state->height != _height) {
+                return false;
+            }
+            {
+                std::lock_guard<std::mutex> lock(_writer);
+                _restored = std::move(state->pages);
             }
 
-            // Bottom border
-            x = space.x;
-            insert_border({x++, y}, BottomLeftCorner);
-            for (unsigned i = 0; i < cell.get_width() + 2; ++i) {
-                insert_border({x++, y}, HorizontalBorder);
+            std::lock_guard<std::mutex> lock(_presenting);
+            if (!state->frame.empty() &&
+                    (_presentation == Presentation::Inline || _presentation == Presentation::AlternateScreen)) {
+                winsize size{};
+                ioctl(STDOUT_FILENO, TIOCGWINSZ, &size);
+                const auto lines = static_cast<std::size_t>(std::count(state->frame.cbegin(), state->frame.cend(), '\n'));
+                if (size.ws_col >= _width && size.ws_row > lines) {
+                    show(state->frame);
+                }
             }
-            insert_border({x, y}, BottomRightCorner);
+            return true;
+        }
+
+        /**
+         * Serve the exports on a local Unix socket, e.g. `socat - UNIX-CONNECT:<path>`.
+         */
+        void serve(const std::string &socket_path, ExportFormat format = ExportFormat::Json) {
+            std::lock_guard<std::mutex> lock(_presenting);
+            _server = std::make_unique<ExportServer>(socket_path);
+            _server_format = format;
+        }
+
+        /**
+         * Limit the CPU time spent by the rendering thread to update the cells of a frame, zero meaning unlimited.
+         * See `Priority`.
+         */
+        void set_frame_budget(std::chrono::nanoseconds budget) {
+            std::lock_guard<std::mutex> lock(_presenting);
+            _frame_budget = budget;
+        }
+
+        FrameStatistics frame_statistics() const {
+            return {_frames.load(), _degraded_frames.load(), _skipped_updates.load()};
         }
 
         void print() {
+            present(true);
+        }
+
+        /**
+         * Update the cells of the displayed page and compose its frame in `frame`, without writing anything.
+         */
+        void render(std::string &frame) {
+            std::lock_guard<std::mutex> lock(_presenting);
+            Reading reading(*this);
+            const std::size_t current = std::min<std::size_t>(_current_page, reading.pages().size() - 1);
+
+            FrameBudget budget(_frame_budget);
+            reading.watch(budget);
+            reading.pages()[current].layout->update(AbstractCell::Clock::now(), budget);
+            account(budget);
+
+            frame.clear();
+            compose_frame(frame, reading.pages(), current);
+        }
+
+      private:
+        void present(bool update) {
+            std::lock_guard<std::mutex> lock(_presenting);
+            forget_cleared_screen();
+            Reading reading(*this);
+            const std::size_t current = std::min<std::size_t>(_current_page, reading.pages().size() - 1);
+            const unsigned int total_height = _height + get_tabs_height(reading.pages());
+
+            if (_presentation == Presentation::Snapshot || _presentation == Presentation::Changes) {
+                if (update) {
+                    present_log(reading, current);
+                }
+                return;
+            }
+
             winsize size{};
             ioctl(STDOUT_FILENO, TIOCGWINSZ, &size);
 
-            if (size.ws_col < _width || size.ws_row < _height) {
-                const auto n = std::count(_buffer.cbegin(), _buffer.cend(), '\n');
+            if (size.ws_col < _width || size.ws_row < total_height) {
+                _frame_displayed = false;
                 std::string too_small_message;
-                too_small_message.insert(0, "\e[0m");
-                too_small_message.insert(0, clear_lines(2));
+                if (_presentation == Presentation::AlternateScreen) {
+                    too_small_message += enter_presentation() + move_home() + "\e[0m" + clear_screen_after_cursor();
+                    _buffer.clear();
+                } else {
+                    too_small_message += clear_lines(2) + "\e[0m";
+                    // Redraw the frame over the message once the terminal is resized
+                    _buffer = "\n\n";
+                }
                 too_small_message += Style(Font::Bold).to_string();
                 too_small_message += "Your terminal is too small to display the UI.\nPlease resize terminal window to at least " +
-                                     std::to_string(_width) + "x" + std::to_string(_height) + ".";
-                std::cout << too_small_message << std::endl;
+                                     std::to_string(_width) + "x" + std::to_string(total_height) + ".\n";
+                output(too_small_message);
                 return;
             }
 
-            std::string next;
+            FrameBudget budget(_frame_budget);
+            reading.watch(budget);
+            reading.pages()[current].layout->update(AbstractCell::Clock::now(), budget, !update);
+            account(budget);
 
             // Calculation of the next string
-            for (const auto &line : _pixels) {
-                for (const auto &pixel : line) {
-                    if (pixel == nullptr) {
-                        next += ' ';
-                    } else {
-                        next += pixel->to_string();
+            _next.clear();
+            compose_frame(_next, reading.pages(), current);
+
+            if (_server && _server->requested()) {
+                _server->publish(export_pages(reading.pages(), _server_format));
+            }
+
+            show(_next);
+        }
+
+        // Write `next` over the displayed frame, unless they are the same. `next` is then the previous frame.
+        void show(std::string &next) {
+            if (_buffer == next) {
+                return;
+            }
+
+            // Written at once, between synchronized update markers
+            std::string &frame = _output;
+            frame.clear();
+            if (_synchronized) {
+                frame += begin_synchronized_update();
+            }
+            if (_presentation == Presentation::AlternateScreen) {
+                // Overwrite the previous frame from the top-left corner, clearing what remains of each line
+                frame += enter_presentation();
+                frame += move_home();
+                for (char c : next) {
+                    if (c == '\n') {
+                        frame += "\e[0m";
+                        frame += clear_line_after_cursor();
                     }
+                    frame += c;
+                }
+                frame += "\e[0m";
+                frame += clear_line_after_cursor();
+                frame += clear_screen_after_cursor();
+            } else {
+                // Necessary update: calculation of the transition
+                if (!_buffer.empty()) {
+                    const unsigned int n = std::count(_buffer.cbegin(), _buffer.cend(), '\n');
+                    append_clear_lines(frame, n);
+                    frame += "\e[0m";
                 }
-                next += '\n';
+                frame += next;
+                frame += _HIDE;
             }
-            // remove the last `\n`
-            next.pop_back();
+            if (_synchronized) {
+                frame += end_synchronized_update();
+            }
+            _buffer.swap(next);
+            _frame_displayed = true;
+
+            write_fully(STDOUT_FILENO, frame);
+        }
 
-            if (_buffer.empty()) {
-                _buffer = next;
-                std::cout << _buffer << _HIDE << std::flush;
+        void compose_frame(std::string &next, const Pages &pages, std::size_t current) const {
+            if (get_tabs_height(pages)) {
+                compose_tabs(next, pages, current);
             }
+            pages[current].layout->compose(next);
+        }
 
-            if (_buffer != next) {
-                _buffer = next;
+        // Place `cell` as saved by the previous run, with its previous content. Called by `publish`.
+        bool restore_cell(Layout &layout, const std::string &page_name, const std::shared_ptr<AbstractCell> &cell,
+                          const std::string &name) {
+            for (auto &page : _restored) {
+                if (page.name != page_name) {
+                    continue;
+                }
+                auto it = std::find_if(page.cells.begin(), page.cells.end(), [&](const SavedCell & saved) {
+                    return saved.name == name && saved.width == cell->get_width() && saved.height == cell->get_height();
+                });
+                if (it == page.cells.end() || !layout.add_cell_at(cell, name, it->x, it->y)) {
+                    return false;
+                }
+                cell->restore_lines(std::move(it->lines));
+                page.cells.erase(it);
+                return true;
+            }
+            return false;
+        }
 
-                // Necessary update: calculation of the transition
-                const unsigned int n = std::count(_buffer.cbegin(), _buffer.cend(), '\n');
-                next.insert(0, "\e[0m");
-                next.insert(0, clear_lines(n));
+        void move_focus(long offset) {
+            std::lock_guard<std::mutex> lock(_presenting);
+            Reading reading(*this);
+            const std::size_t current = std::min<std::size_t>(_current_page, reading.pages().size() - 1);
+            const auto &layout = *reading.pages()[current].layout;
+
+            const AbstractCell *previous = layout.find_cell(layout.get_focus());
+            const AbstractCell *next = layout.cycle_cell(previous, previous == nullptr ? 0 : offset);
+            highlight(next);
+            auto pages = _pages.load();
+            redraw_cells(*pages, current, {previous, next});
+        }
+
+        // Scroll the focused cell by `lines`, or by `lines` heights of the cell with `by_page`
+        void scroll_focus(long lines, bool by_page) {
+            std::lock_guard<std::mutex> lock(_presenting);
+            Reading reading(*this);
+            const std::size_t current = std::min<std::size_t>(_current_page, reading.pages().size() - 1);
+            const auto &layout = *reading.pages()[current].layout;
+            AbstractCell *cell = layout.find_cell(layout.get_focus());
+            if (cell == nullptr) {
+                return;
+            }
+            cell->scroll(by_page ? lines * static_cast<long>(cell->get_height()) : lines);
+            redraw_cells(reading.pages(), current, {cell});
+        }
+
+        /**
+         * Overwrite the rectangles of `cells` on the displayed frame, instead of writing a whole frame: the cursor is
+         * moved from the end of the frame, where it is left by `present`, and brought back.
+         */
+        void redraw_cells(const Pages &pages, std::size_t current, std::initializer_list<const AbstractCell *> cells) {
+            forget_cleared_screen();
+            if (!_frame_displayed ||
+                    (_presentation != Presentation::Inline && _presentation != Presentation::AlternateScreen)) {
+                return;
+            }
+            const unsigned int tabs_height = get_tabs_height(pages);
+            const unsigned int last_line = _height + tabs_height - 1;
+            auto move = [last_line, tabs_height](unsigned int x, unsigned int y) {
+                std::string result = "\e8\r";
+                if (last_line > y + tabs_height) {
+                    result += "\e[" + std::to_string(last_line - y - tabs_height) + "A";
+                }
+                if (x > 0) {
+                    result += "\e[" + std::to_string(x) + "C";
+                }
+                // "\e8" also restores the attributes saved at the end of the frame, hidden in Inline mode
+                result += "\e[0m";
+                return result;
+            };
+
+            const auto &layout = *pages[current].layout;
+            std::string frame = "\e7";
+            for (const auto *cell : cells) {
+                if (cell != nullptr) {
+                    layout.compose_cell(*cell, frame, move);
+                }
+            }
+            frame += "\e8";
+            output(frame);
+
+            // The frame now on the screen, compared with the next one
+            _buffer.clear();
+            compose_frame(_buffer, pages, current);
+        }
+
+        void account(const FrameBudget &budget) {
+            _frames.fetch_add(1, std::memory_order_relaxed);
+            if (budget.skipped > 0) {
+                _degraded_frames.fetch_add(1, std::memory_order_relaxed);
+                _skipped_updates.fetch_add(budget.skipped, std::memory_order_relaxed);
+            }
+        }
+
+        void present_log(Reading &reading, std::size_t current) {
+            const auto now = std::chrono::steady_clock::now();
+            if (_last_snapshot != std::chrono::steady_clock::time_point{} && now - _last_snapshot < _snapshot_interval) {
+                return;
+            }
+            _last_snapshot = now;
+
+            std::string lines;
+            if (_presentation == Presentation::Snapshot) {
+                FrameBudget budget(_frame_budget);
+                reading.watch(budget);
+                reading.pages()[current].layout->update(now, budget);
+                account(budget);
+
+                std::string next;
+                compose_frame(next, reading.pages(), current);
+                // Without the trailing spaces and the empty lines at the bottom of the layout
+                std::string plain;
+                std::istringstream stream(strip_escapes(next));
+                for (std::string line; std::getline(stream, line);) {
+                    line.erase(line.find_last_not_of(' ') + 1);
+                    plain += line;
+                    plain += '\n';
+                }
+                plain.erase(plain.find_last_not_of('\n') + 1);
+                next = std::move(plain);
+                if (next == _buffer) {
+                    return;
+                }
+                lines = next + "\n\n";
+                _buffer = std::move(next);
+            } else {
+                // As in a terminal, the hidden pages aren't evaluated: their cells are written once displayed
+                FrameBudget budget(_frame_budget);
+                reading.watch(budget);
+                reading.pages()[current].layout->update(now, budget);
+                account(budget);
+
+                std::lock_guard<std::mutex> lock(_logging);
+                KeyValueExporter exporter;
+                export_page(reading.pages()[current], exporter, [&](const AbstractCell & exported) {
+                    const auto &cell = exporter.cells().back();
+                    auto &last = _last_values[&exported];
+                    std::vector<std::pair<std::string, std::string>> changed;
+                    for (const auto &value : cell.values) {
+                        if (std::find(last.cbegin(), last.cend(), value) == last.cend()) {
+                            changed.push_back(value);
+                        }
+                    }
+                    if (!changed.empty()) {
+                        lines += KeyValueExporter::to_line(cell.name, changed);
+                    }
+                    last = cell.values;
+                });
+            }
+
+            if (_server && _server->requested()) {
+                _server->publish(export_pages(reading.pages(), _server_format));
+            }
+            write_fully(STDOUT_FILENO, lines);
+        }
+
+        // Write a whole frame at once, between synchronized update markers
+        void output(const std::string &frame) const {
+            if (_synchronized) {
+                write_fully(STDOUT_FILENO, begin_synchronized_update() + frame + end_synchronized_update());
+            } else {
+                write_fully(STDOUT_FILENO, frame);
+            }
+        }
+
+        // The signal handlers leave the alternate screen too, e.g. on Ctrl-C, where the destructor isn't called
+        std::string enter_presentation() {
+            if (_entered_alternate_screen) {
+                return "";
+            }
+            _entered_alternate_screen = true;
+            detail::install_signal_handlers();
+            detail::left_alternate_screen = 0;
+            detail::alternate_screen = 1;
+            return enter_alternate_screen() + hide_cursor();
+        }
+
+        void leave_presentation() {
+            if (!_entered_alternate_screen) {
+                return;
+            }
+            _entered_alternate_screen = false;
+            detail::alternate_screen = 0;
+            detail::uninstall_signal_handlers();
+            write_fully(STDOUT_FILENO, "\e[0m" + show_cursor() + leave_alternate_screen());
+        }
 
-                std::cout << next << _HIDE << std::flush;
+        // After a suspension, the alternate screen is entered again blank: the next frame is written as a whole
+        void forget_cleared_screen() {
+            if (detail::alternate_screen_cleared) {
+                detail::alternate_screen_cleared = 0;
+                _buffer.clear();
+                _frame_displayed = false;
             }
         }
     };
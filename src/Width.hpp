@@ -0,0 +1,183 @@
+//
+// Created by terae on 19/10/26.
+//
+
+#ifndef AWESOME_VIEWER_WIDTH_H
+#define AWESOME_VIEWER_WIDTH_H
+
+#include "Format.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+
+namespace AwesomeViewer {
+
+    namespace detail {
+        struct CodepointRange {
+            char32_t first, last;
+        };
+
+        // Combining marks, zero-width spaces and joiners, variation selectors: they take no column
+        constexpr CodepointRange zero_width_ranges[] = {
+            {0x0300, 0x036F}, {0x0483, 0x0489}, {0x0591, 0x05BD}, {0x05BF, 0x05BF}, {0x05C1, 0x05C2},
+            {0x05C4, 0x05C5}, {0x05C7, 0x05C7}, {0x0610, 0x061A}, {0x064B, 0x065F}, {0x0670, 0x0670},
+            {0x06D6, 0x06DC}, {0x06DF, 0x06E4}, {0x06E7, 0x06E8}, {0x06EA, 0x06ED}, {0x0711, 0x0711},
+            {0x0730, 0x074A}, {0x07A6, 0x07B0}, {0x0816, 0x082D}, {0x0900, 0x0902}, {0x093C, 0x093C},
+            {0x0941, 0x0948}, {0x094D, 0x094D}, {0x0951, 0x0957}, {0x0E31, 0x0E31}, {0x0E34, 0x0E3A},
+            {0x0E47, 0x0E4E}, {0x0EB1, 0x0EB1}, {0x0EB4, 0x0EBC}, {0x0EC8, 0x0ECD}, {0x1AB0, 0x1AFF},
+            {0x1DC0, 0x1DFF}, {0x200B, 0x200F}, {0x202A, 0x202E}, {0x2060, 0x2064}, {0x20D0, 0x20FF},
+            {0x302A, 0x302D}, {0x3099, 0x309A}, {0xFE00, 0xFE0F}, {0xFE20, 0xFE2F}, {0xFEFF, 0xFEFF},
+            {0xE0001, 0xE0001}, {0xE0020, 0xE007F}, {0xE0100, 0xE01EF}
+        };
+
+        // East Asian wide and fullwidth characters, emoji: they take two columns
+        constexpr CodepointRange wide_ranges[] = {
+            {0x1100, 0x115F}, {0x231A, 0x231B}, {0x2329, 0x232A}, {0x23E9, 0x23EC}, {0x23F0, 0x23F0},
+            {0x23F3, 0x23F3}, {0x25FD, 0x25FE}, {0x2614, 0x2615}, {0x2648, 0x2653}, {0x267F, 0x267F},
+            {0x2693, 0x2693}, {0x26A1, 0x26A1}, {0x26AA, 0x26AB}, {0x26BD, 0x26BE}, {0x26C4, 0x26C5},
+            {0x26CE, 0x26CE}, {0x26D4, 0x26D4}, {0x26EA, 0x26EA}, {0x26F2, 0x26F3}, {0x26F5, 0x26F5},
+            {0x26FA, 0x26FA}, {0x26FD, 0x26FD}, {0x2705, 0x2705}, {0x270A, 0x270B}, {0x2728, 0x2728},
+            {0x274C, 0x274C}, {0x274E, 0x274E}, {0x2753, 0x2755}, {0x2757, 0x2757}, {0x2795, 0x2797},
+            {0x27B0, 0x27B0}, {0x27BF, 0x27BF}, {0x2B1B, 0x2B1C}, {0x2B50, 0x2B50}, {0x2B55, 0x2B55},
+            {0x2E80, 0x3029}, {0x302E, 0x303E}, {0x3041, 0x3098}, {0x309B, 0x33FF}, {0x3400, 0x4DBF},
+            {0x4E00, 0x9FFF}, {0xA000, 0xA4CF}, {0xA960, 0xA97F}, {0xAC00, 0xD7A3}, {0xF900, 0xFAFF},
+            {0xFE10, 0xFE19}, {0xFE30, 0xFE6F}, {0xFF00, 0xFF60}, {0xFFE0, 0xFFE6}, {0x16FE0, 0x16FE4},
+            {0x17000, 0x18AFF}, {0x1B000, 0x1B2FF}, {0x1F004, 0x1F004}, {0x1F0CF, 0x1F0CF}, {0x1F18E, 0x1F18E},
+            {0x1F191, 0x1F19A}, {0x1F200, 0x1F251}, {0x1F300, 0x1F64F}, {0x1F680, 0x1F6FF}, {0x1F7E0, 0x1F7EB},
+            {0x1F90C, 0x1F9FF}, {0x1FA70, 0x1FAFF}, {0x20000, 0x2FFFD}, {0x30000, 0x3FFFD}
+        };
+
+        template<std::size_t N>
+        constexpr bool in_ranges(const CodepointRange (&ranges)[N], char32_t c) {
+            auto it = std::upper_bound(std::begin(ranges), std::end(ranges), c, [](char32_t value,
+            const CodepointRange & range) {
+                return value < range.first;
+            });
+            return it != std::begin(ranges) && c <= (it - 1)->last;
+        }
+    }
+
+    /**
+     * True if `str` only has printable ASCII characters, each one taking one column. The bytes are tested 8 at a
+     * time, in a loop the compiler vectorises.
+     */
+    inline bool is_printable_ascii(std::string_view str) {
+        constexpr std::uint64_t high_bits = 0x8080808080808080ull;
+        std::uint64_t bits = 0;
+        std::uint64_t controls = 0;
+        std::size_t i = 0;
+        for (; i + 8 <= str.size(); i += 8) {
+            std::uint64_t word;
+            std::memcpy(&word, str.data() + i, 8);
+            bits |= word;
+            // Set the high bit of the bytes below 0x20, and of the bytes equal to 0x7f
+            controls |= (word - 0x2020202020202020ull) & ~word;
+            const std::uint64_t del = word ^ 0x7f7f7f7f7f7f7f7full;
+            controls |= (del - 0x0101010101010101ull) & ~del;
+        }
+        for (; i < str.size(); ++i) {
+            const auto c = static_cast<unsigned char>(str[i]);
+            bits |= c;
+            controls |= (c < 0x20 || c == 0x7f ? 0x80 : 0);
+        }
+        return ((bits | controls) & high_bits) == 0;
+    }
+
+    /**
+     * Decode the character starting at `i` and move `i` after it. An invalid sequence is one U+FFFD per byte.
+     */
+    inline char32_t decode_utf8(std::string_view str, std::size_t &i) {
+        const auto c = static_cast<unsigned char>(str[i++]);
+        if (c < 0x80) {
+            return c;
+        }
+        const std::size_t length = (c >= 0xF0 ? 4 : c >= 0xE0 ? 3 : c >= 0xC0 ? 2 : 0);
+        if (length == 0 || i + length - 1 > str.size()) {
+            return 0xFFFD;
+        }
+        char32_t result = c & (0x7F >> length);
+        for (std::size_t k = 1; k < length; ++k) {
+            const auto next = static_cast<unsigned char>(str[i]);
+            if ((next & 0xC0) != 0x80) {
+                return 0xFFFD;
+            }
+            result = (result << 6) | (next & 0x3F);
+            ++i;
+        }
+        return result;
+    }
+
+    // Number of columns taken by a character in a terminal: 0, 1 or 2
+    constexpr unsigned int codepoint_width(char32_t c) {
+        if (c < 0x20 || (c >= 0x7F && c < 0xA0)) {
+            return 0;
+        }
+        if (c < 0x300) {
+            return 1;
+        }
+        if (detail::in_ranges(detail::zero_width_ranges, c)) {
+            return 0;
+        }
+        return detail::in_ranges(detail::wide_ranges, c) ? 2 : 1;
+    }
+
+    inline std::size_t display_width(std::string_view str) {
+        if (is_printable_ascii(str)) {
+            return str.size();
+        }
+        std::size_t width = 0;
+        for (std::size_t i = 0; i < str.size();) {
+            width += codepoint_width(decode_utf8(str, i));
+        }
+        return width;
+    }
+
+    struct WidthPrefix {
+        std::size_t bytes;
+        std::size_t width;
+    };
+
+    /**
+     * Longest prefix of `str` taking at most `max_width` columns, without cutting a character. The zero-width
+     * characters following the prefix are kept with it.
+     */
+    inline WidthPrefix prefix_of_width(std::string_view str, std::size_t max_width) {
+        if (is_printable_ascii(str)) {
+            const auto n = std::min(str.size(), max_width);
+            return {n, n};
+        }
+        WidthPrefix result{0, 0};
+        for (std::size_t i = 0; i < str.size();) {
+            const auto width = codepoint_width(decode_utf8(str, i));
+            if (result.width + width > max_width) {
+                break;
+            }
+            result = {i, result.width + width};
+        }
+        return result;
+    }
+
+    /**
+     * Replace `out` by `text` truncated or padded with spaces to take exactly `width` columns, reusing its storage.
+     */
+    inline void align_to_width(std::string &out, std::string_view text, std::size_t width, Align align = Align::Left) {
+        const auto prefix = prefix_of_width(text, width);
+        const auto padding = width - prefix.width;
+        const auto before = (align == Align::Right ? padding : align == Align::Center ? padding / 2 : 0);
+
+        out.assign(before, ' ');
+        out.append(text.data(), prefix.bytes);
+        out.append(padding - before, ' ');
+    }
+
+    inline std::string align_to_width(std::string_view text, std::size_t width, Align align = Align::Left) {
+        std::string result;
+        align_to_width(result, text, width, align);
+        return result;
+    }
+}
+
+#endif //AWESOME_VIEWER_WIDTH_H
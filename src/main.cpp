@@ -3,13 +3,40 @@
 //
 
 #include "Cell.hpp"
+#include "HistogramCell.hpp"
+#include "RateCell.hpp"
+#include "SharedMetrics.hpp"
+#include "TaskProgressCell.hpp"
+#include "TextCell.hpp"
 #include "VirtualTerminal.hpp"
+#include <cstdlib>
+#include <fstream>
 #include <iostream>
+#include <random>
 
 using namespace AwesomeViewer;
 
+AsyncGenerator<std::string> load_average(Executor &executor) {
+    for (;;) {
+        std::ifstream file("/proc/loadavg");
+        std::string one, five;
+        file >> one >> five;
+        co_yield one + " " + five;
+        co_await executor.sleep_for(std::chrono::seconds(1));
+    }
+}
+
 int main() {
-    VirtualTerminal vt(56, 15);
+    VirtualTerminal vt(56, 17);
+    vt.set_frame_budget(std::chrono::milliseconds(5));
+    // The last frame of the previous run is displayed until the cells are updated. Kept in the private runtime
+    // directory of the user, not in a shared one where the path could be taken by someone else.
+    const char *runtime_directory = std::getenv("XDG_RUNTIME_DIR");
+    const std::string state_path = (runtime_directory == nullptr ? "" :
+                                    std::string(runtime_directory) + "/AwesomeViewerExample.state");
+    if (!state_path.empty()) {
+        vt.restore_state(state_path);
+    }
 
     StringCell c1(22, 4, "Hello communicator!\nI'm an helper text\nAnd I am a very long string");
     vt.add_cell(c1, "Communicator");
@@ -21,6 +48,7 @@ int main() {
         result["very long name"] = 8;
         return result;
     });
+    c2.set_refresh_interval(std::chrono::seconds(1));
     vt.add_cell(c2, "ModuleManager");
 
     std::vector<std::pair<Style, std::string>> v;
@@ -29,8 +57,10 @@ int main() {
 
     int timer = 0;
     StringCell c4(7, 2, [&timer]() {
-        std::string str_timer = std::to_string(timer / 2);
-        return std::string(3 - str_timer.size(), ' ') + str_timer + " s";
+        std::string str_timer(5, ' ');
+        format(std::span<char>(str_timer).first(3), timer / 2, Align::Right);
+        str_timer[4] = 's';
+        return str_timer;
     });
     vt.add_cell(c4, "Timer");
 
@@ -48,8 +78,64 @@ int main() {
     MapCell<StyleString> c8(19, 1, {{"test", StyleString(Style(Font::Italic), "It works!")}});
     vt.add_cell(c8);
 
+    StringCell c9(9, 1, vt.executor().spawn(load_average(vt.executor())));
+    vt.add_cell(c9, "Load");
+
+    auto metrics = vt.add_page("Metrics");
+
+    Counter requests, errors;
+    RateCell c10(40, 3, {{"requests", &requests}, {"errors", &errors}});
+    // Updated even when the 5 ms of CPU per frame are spent
+    c10.set_priority(Priority::Critical);
+    vt.add_cell(c10, "Rates", metrics);
+
+    LatencyHistogram latencies;
+    HistogramCell c11(30, 5, latencies);
+    vt.add_cell(c11, "Latency", metrics);
+
+    TaskSet shards(64, 200);
+    TaskProgressCell c12(44, 4, shards);
+    vt.add_cell(c12, "Shards", metrics);
+
+    auto log = vt.add_page("Log");
+    TextCell c13(50, 12);
+    vt.add_cell(c13, "Requests", log);
+
+    // Also rendered by `AwesomeViewer /AwesomeViewerExample`, in another terminal. Replaces the segment of a run
+    // interrupted by Ctrl-C.
+    SharedMetrics shared("/AwesomeViewerExample", 256, true);
+    auto shared_requests = shared.add_counter("requests.total");
+    auto shared_errors = shared.add_counter("requests.errors");
+    auto shared_progress = shared.add_gauge("example.progress");
+    auto shared_page = shared.add_text("example.page");
+
+    std::mt19937 random;
+    std::lognormal_distribution<> latency(11.0, 1.0);
+
     for (; timer <= 100; ++timer) {
+        for (int i = 0; i < 1000; ++i) {
+            requests.add();
+            latencies.record(static_cast<std::uint64_t>(latency(random)));
+        }
+        errors.add(timer % 3);
+        c13.append("frame " + std::to_string(timer) + ": 1000 requests, " + std::to_string(timer % 3) + " errors\n");
+        for (std::size_t shard = 0; shard < shards.size(); ++shard) {
+            shards.advance(shard, random() % 5);
+        }
+
+        shared_requests.add(1000);
+        shared_errors.add(timer % 3);
+        shared_progress.set(timer / 100.0);
+        shared_page.set(vt.page_name(vt.current_page()));
+
+        if (timer % 30 == 29) {
+            vt.next_page();
+        }
         vt.print();
-        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        // Tab focuses a cell, the arrows scroll it
+        vt.wait_for(std::chrono::milliseconds(100));
+    }
+    if (!state_path.empty()) {
+        vt.save_state(state_path);
     }
 }
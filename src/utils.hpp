@@ -6,8 +6,13 @@
 #define AWESOME_VIEWER_UTILS_HPP
 
 #include <string>
+#include <string_view>
 #include <vector>
 #include <algorithm>
+#include <cerrno>
+#include <unistd.h>
+
+#include "Format.hpp"
 
 namespace AwesomeViewer {
 
@@ -17,7 +22,16 @@ namespace AwesomeViewer {
 
     template<class T>
     inline auto to_string(T const &x) -> decltype(std::to_string(x)) {
-        return std::to_string(x);
+        Chars chars;
+        if constexpr (std::is_floating_point<T>::value) {
+            if (!chars.append_number(x, std::chars_format::fixed, 6)) {
+                // Too long for the stack buffer
+                return std::to_string(x);
+            }
+        } else {
+            chars.append_number(x);
+        }
+        return std::string(chars.view());
     }
 
 
@@ -58,6 +72,26 @@ namespace AwesomeViewer {
         return result;
     }
 
+    // ' ', '▁', '▂', ..., '█' for 0 to 8 eighths of height
+    inline std::string_view vertical_block(unsigned int eighths) {
+        static constexpr std::string_view blocks[] = {" ", "▁", "▂", "▃", "▄", "▅", "▆", "▇", "█"};
+        return blocks[std::min(eighths, 8u)];
+    }
+
+    // ' ', '▏', '▎', ..., '█' for 0 to 8 eighths of width
+    inline std::string_view horizontal_block(unsigned int eighths) {
+        static constexpr std::string_view blocks[] = {" ", "▏", "▎", "▍", "▌", "▋", "▊", "▉", "█"};
+        return blocks[std::min(eighths, 8u)];
+    }
+
+    // Bar of `width` characters filled at `fraction`, with a precision of an eighth of character
+    inline void append_bar(std::string &out, double fraction, unsigned int width) {
+        const auto eighths = static_cast<unsigned int>(std::clamp(fraction, 0.0, 1.0) * width * 8);
+        for (unsigned int i = 0; i < width; ++i) {
+            out += horizontal_block(std::min(8u, eighths - std::min(eighths, i * 8)));
+        }
+    }
+
     inline std::string clear_before_cursor() {
         return "\e[0K";
     }
@@ -79,6 +113,82 @@ namespace AwesomeViewer {
     inline std::string clear_lines(unsigned long n = 1) {
         return "\e[0m" + clear_before_cursor() + ((n) ? repeat(n, clear_line() + move_up()) : std::string(""));
     }
+
+    // Same as `out += clear_lines(n)`, without an intermediate string
+    inline void append_clear_lines(std::string &out, unsigned long n = 1) {
+        out += "\e[0m";
+        out += clear_before_cursor();
+        for (unsigned long i = 0; i < n; ++i) {
+            out += clear_line();
+            out += move_up();
+        }
+    }
+
+    inline std::string clear_line_after_cursor() {
+        return "\e[K";
+    }
+
+    inline std::string clear_screen_after_cursor() {
+        return "\e[J";
+    }
+
+    inline std::string move_home() {
+        return "\e[H";
+    }
+
+    inline std::string hide_cursor() {
+        return "\e[?25l";
+    }
+
+    inline std::string show_cursor() {
+        return "\e[?25h";
+    }
+
+    inline std::string enter_alternate_screen() {
+        return "\e[?1049h";
+    }
+
+    inline std::string leave_alternate_screen() {
+        return "\e[?1049l";
+    }
+
+    inline std::string begin_synchronized_update() {
+        return "\e[?2026h";
+    }
+
+    inline std::string end_synchronized_update() {
+        return "\e[?2026l";
+    }
+
+    // Remove the CSI escape sequences, e.g. the styles
+    inline std::string strip_escapes(std::string_view str) {
+        std::string result;
+        result.reserve(str.size());
+        for (std::size_t i = 0; i < str.size(); ++i) {
+            if (str[i] == '\e' && i + 1 < str.size() && str[i + 1] == '[') {
+                i += 2;
+                while (i < str.size() && (str[i] < 0x40 || str[i] > 0x7e)) {
+                    ++i;
+                }
+            } else {
+                result += str[i];
+            }
+        }
+        return result;
+    }
+
+    inline void write_fully(int fd, std::string_view data) {
+        while (!data.empty()) {
+            auto n = write(fd, data.data(), data.size());
+            if (n < 0 && errno == EINTR) {
+                continue;
+            }
+            if (n <= 0) {
+                return;
+            }
+            data.remove_prefix(static_cast<std::size_t>(n));
+        }
+    }
 }
 
 #endif //AWESOME_VIEWER_UTILS_HPP
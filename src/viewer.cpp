@@ -0,0 +1,167 @@
+//
+// Created by terae on 19/10/26.
+//
+
+#include "Cell.hpp"
+#include "Format.hpp"
+#include "SharedMetrics.hpp"
+#include "VirtualTerminal.hpp"
+#include "Width.hpp"
+
+#include <iostream>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace AwesomeViewer;
+
+namespace {
+    struct Group {
+        std::string name;
+        std::vector<std::pair<std::string, std::size_t>> slots;
+        unsigned int width = 0;
+    };
+
+    std::string read_value(const SharedMetricsReader &reader, SlotType type, std::size_t index) {
+        std::string value(24, ' ');
+        switch (type) {
+            case SlotType::Counter:
+                format(value, reader.read_counter(index));
+                break;
+            case SlotType::Gauge:
+                format(value, reader.read_gauge(index));
+                break;
+            case SlotType::Text:
+                return reader.read_text(index);
+        }
+        value.erase(value.find_last_not_of(' ') + 1);
+        return value;
+    }
+
+    // One cell per prefix of the slot names
+    std::vector<std::pair<std::string, std::shared_ptr<AbstractCell>>> make_cells(
+    const std::shared_ptr<SharedMetricsReader> &reader, const std::vector<SharedMetricsReader::SlotInfo> &slots,
+    unsigned int max_width) {
+        std::vector<Group> groups;
+        std::map<std::string, std::size_t> indexes;
+
+        for (std::size_t i = 0; i < slots.size(); ++i) {
+            const auto &name = slots[i].name;
+            const auto dot = name.find('.');
+            const std::string prefix = (dot == std::string::npos ? "" : name.substr(0, dot));
+            const std::string key = (dot == std::string::npos ? name : name.substr(dot + 1));
+
+            auto it = indexes.find(prefix);
+            if (it == indexes.end()) {
+                it = indexes.emplace(prefix, groups.size()).first;
+                groups.push_back({prefix.empty() ? "metrics" : prefix, {}, 0});
+            }
+            auto &group = groups[it->second];
+            group.slots.emplace_back(key, i);
+            const auto value_width = (slots[i].type == SlotType::Text ? SharedText::max_size : 12);
+            group.width = std::max(group.width, static_cast<unsigned int>(display_width(key) + 3 + value_width));
+        }
+
+        std::vector<std::pair<std::string, std::shared_ptr<AbstractCell>>> cells;
+        for (auto &group : groups) {
+            const auto height = static_cast<unsigned int>(group.slots.size());
+            const auto width = std::min(group.width, max_width > 4 ? max_width - 4 : 1);
+            auto types = std::vector<SlotType>();
+            for (const auto &slot : group.slots) {
+                types.push_back(slots[slot.second].type);
+            }
+            cells.emplace_back(group.name, std::make_shared<MapCell<std::string>>(width, height,
+            [reader, entries = std::move(group.slots), types = std::move(types)]() {
+                std::map<std::string, std::string> result;
+                for (std::size_t i = 0; i < entries.size(); ++i) {
+                    result[entries[i].first] = read_value(*reader, types[i], entries[i].second);
+                }
+                return result;
+            }));
+        }
+        return cells;
+    }
+}
+
+/**
+ * AwesomeViewer <segment> [width height]
+ * Renders the metrics published by `SharedMetrics` in the shared memory segment <segment>, e.g. "/my_application".
+ * The cells are rebuilt when the producer registers new slots, or when it is restarted.
+ */
+int main(int argc, char *argv[]) {
+    if (argc != 2 && argc != 4) {
+        std::cerr << "Usage: " << argv[0] << " <segment> [width height]" << std::endl;
+        return 1;
+    }
+    const std::string segment = argv[1];
+    const unsigned int width = (argc == 4 ? static_cast<unsigned int>(std::stoul(argv[2])) : 120);
+    const unsigned int height = (argc == 4 ? static_cast<unsigned int>(std::stoul(argv[3])) : 40);
+
+    VirtualTerminal vt(width, height);
+    const std::string waiting_text = "Waiting for " + segment + "...";
+    StringCell waiting(static_cast<unsigned int>(std::min<std::size_t>(display_width(waiting_text),
+                                                                       width > 4 ? width - 4 : 1)), 1, waiting_text);
+    auto show_waiting = [&vt, &waiting]() {
+        try {
+            vt.add_cell(waiting);
+        } catch (std::runtime_error &) {
+            // Terminal too small even for this message
+        }
+    };
+
+    std::shared_ptr<SharedMetricsReader> reader;
+    std::vector<std::shared_ptr<AbstractCell>> cells;
+    std::uint32_t version = 0;
+    std::chrono::steady_clock::time_point last_check{};
+
+    show_waiting();
+    for (;;) {
+        bool rebuild = false;
+        const auto now = std::chrono::steady_clock::now();
+        if (now - last_check >= std::chrono::seconds(1)) {
+            last_check = now;
+            if (reader == nullptr || reader->is_stale()) {
+                std::shared_ptr<SharedMetricsReader> attached;
+                try {
+                    attached = std::make_shared<SharedMetricsReader>(segment);
+                } catch (std::runtime_error &) {
+                    // Not created yet, or the producer exited
+                }
+                rebuild = attached != nullptr || reader != nullptr;
+                reader = std::move(attached);
+            }
+        }
+        rebuild = rebuild || (reader != nullptr && reader->layout_version() != version);
+
+        if (rebuild) {
+            for (const auto &cell : cells) {
+                vt.remove_cell(*cell);
+            }
+            vt.remove_cell(waiting);
+            cells.clear();
+
+            const auto slots = (reader == nullptr ? std::vector<SharedMetricsReader::SlotInfo>() :
+                                reader->slots(&version));
+            if (reader != nullptr && reader->is_stale()) {
+                // The producer died while registering a slot: wait for a new one
+                reader = nullptr;
+            }
+            if (reader == nullptr) {
+                show_waiting();
+            } else {
+                for (auto &cell : make_cells(reader, slots, width)) {
+                    try {
+                        vt.add_cell(cell.second, cell.first);
+                        cells.push_back(std::move(cell.second));
+                    } catch (std::runtime_error &) {
+                        // No space left for this group
+                    }
+                }
+            }
+        }
+
+        vt.print();
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+}
@@ -0,0 +1,131 @@
+//
+// Created by terae on 19/10/26.
+//
+
+#include "check.hpp"
+
+#include "Cell.hpp"
+
+#include <chrono>
+#include <functional>
+#include <string>
+#include <vector>
+
+using namespace AwesomeViewer;
+using namespace AwesomeViewer::Test;
+
+namespace {
+    std::vector<std::string> plain_lines(const AbstractCell &cell) {
+        std::vector<std::string> lines;
+        for (const auto &line : cell.get_lines()) {
+            lines.push_back(line.to_plain_string());
+        }
+        return lines;
+    }
+
+    std::string joined(const std::vector<std::string> &lines) {
+        std::string result;
+        for (const auto &line : lines) {
+            result += "[" + line + "]";
+        }
+        return result;
+    }
+
+    void check_wrapped(const std::string &text, unsigned int width, unsigned int height,
+                       const std::vector<std::string> &expected) {
+        StringCell cell(width, height, text);
+        cell.set_word_wrap(true);
+        cell.update();
+        const auto lines = plain_lines(cell);
+        check(lines == expected, "\"" + text + "\" wrapped at " + std::to_string(width) + ": " + joined(lines) +
+              " instead of " + joined(expected));
+    }
+
+    void check_word_wrap() {
+        check_wrapped("one two three", 7, 2, {"one two", "three  "});
+        // A word longer than the line is cut
+        check_wrapped("abcdefghij klm", 5, 1, {"abcde", "fghij", "klm  "});
+        // Blank paragraphs are kept
+        check_wrapped("a\n\nb", 5, 1, {"a    ", "     ", "b    "});
+        // Every line is padded to the width, and the cell to its height
+        check_wrapped("ab  ", 5, 3, {"ab   ", "     ", "     "});
+        check_wrapped("", 3, 2, {"   ", "   "});
+
+        // Without word wrap, each paragraph is a truncated line
+        StringCell truncated(5, 2, std::string("abcdefgh\nij"));
+        truncated.update();
+        check(plain_lines(truncated) == std::vector<std::string>({"abcde", "ij   "}), "lines truncated to the width");
+    }
+
+    // Only the paragraphs from the first changed one are wrapped again
+    void check_wrap_cache() {
+        std::string text = "first paragraph\nsecond";
+        StringCell cell(8, 4, std::function<std::string()>([&text]() {
+            return text;
+        }));
+        cell.set_word_wrap(true);
+        cell.update();
+        check(cell.rewrapped_paragraphs() == 2, "every paragraph is wrapped at first");
+
+        text = "first paragraph\nsecond changed";
+        cell.update();
+        check(cell.rewrapped_paragraphs() == 1, "the unchanged first paragraph is cached");
+        check(plain_lines(cell) == std::vector<std::string>({"first   ", "paragrap", "h       ", "second  ",
+                                                             "changed "}),
+              "the cached lines are followed by the new ones: " + joined(plain_lines(cell)));
+
+        text = "First paragraph\nsecond changed";
+        cell.update();
+        check(cell.rewrapped_paragraphs() == 2, "a change of the first paragraph wraps everything again");
+    }
+
+    // First time from `from` at which `cell` is due, to the nanosecond
+    AbstractCell::Clock::time_point first_due(const AbstractCell &cell, AbstractCell::Clock::time_point from,
+            AbstractCell::Clock::duration range) {
+        auto low = from, high = from + range;
+        while (high - low > AbstractCell::Clock::duration(1)) {
+            const auto middle = low + (high - low) / 2;
+            (cell.is_due(middle) ? high : low) = middle;
+        }
+        return cell.is_due(low) ? low : high;
+    }
+
+    // The refreshes keep the phase of the cell, even after missed frames, and the phases of the cells differ
+    void check_refresh_interval() {
+        using namespace std::chrono_literals;
+        const auto start = AbstractCell::Clock::time_point{} + 1h;
+        int updates = 0;
+        StringCell cell(5, 1, std::function<std::string()>([&updates]() {
+            return std::to_string(++updates);
+        }));
+        StringCell other(5, 1, std::string("other"));
+        cell.set_refresh_interval(1s);
+        other.set_refresh_interval(1s);
+
+        check(cell.refresh(start) && other.refresh(start), "a cell without content is refreshed at once");
+        const auto due = first_due(cell, start, 1s);
+        check(due < start + 1s, "the first refresh is within the interval");
+        check(first_due(other, start, 1s) != due, "two cells sharing an interval are refreshed at different times");
+
+        check(!cell.refresh(due - 1ns) && updates == 1, "not refreshed before its time");
+        check(cell.refresh(due) && updates == 2, "refreshed at its time");
+        check(!cell.is_due(due + 1s - 1ns) && cell.is_due(due + 1s), "then refreshed after the interval");
+
+        // Late by 2.5 intervals: refreshed once, then back on its phase
+        check(cell.refresh(due + 3500ms) && updates == 3, "a late cell is refreshed once");
+        check(!cell.refresh(due + 4s - 1ns) && updates == 3 && cell.refresh(due + 4s) && updates == 4,
+              "the missed refreshes are skipped and the phase is kept");
+
+        // Without interval, refreshed at each frame
+        cell.set_refresh_interval(AbstractCell::Clock::duration::zero());
+        check(cell.refresh(due + 4s) && updates == 5, "refreshed at each frame without an interval");
+    }
+}
+
+int main() {
+    check_word_wrap();
+    check_wrap_cache();
+    check_refresh_interval();
+
+    return result();
+}
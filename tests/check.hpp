@@ -0,0 +1,59 @@
+//
+// Created by terae on 19/10/26.
+//
+
+#ifndef AWESOME_VIEWER_CHECK_H
+#define AWESOME_VIEWER_CHECK_H
+
+#include "Export.hpp"
+
+#include <cstdio>
+#include <map>
+#include <string>
+
+namespace AwesomeViewer::Test {
+
+    inline int failures = 0;
+
+    inline void check(bool condition, const std::string &what) {
+        if (!condition) {
+            std::fprintf(stderr, "FAILED: %s\n", what.c_str());
+            ++failures;
+        }
+    }
+
+    // Numbers exported by a cell, fields and entries alike, by key
+    class NumberExporter final : public Exporter {
+      public:
+        std::map<std::string, double> values;
+
+        void begin_cell(std::string_view, std::string_view, std::string_view) override {}
+
+        void end_cell() override {}
+
+        void field(std::string_view key, double value) override {
+            values[std::string(key)] = value;
+        }
+
+        void field(std::string_view, std::string_view) override {}
+
+        void entry(std::string_view key, double value) override {
+            values[std::string(key)] = value;
+        }
+
+        void entry(std::string_view, std::string_view) override {}
+
+        void line(std::string_view) override {}
+
+        std::string finish() override {
+            return "";
+        }
+    };
+
+    // Exit status of the test
+    inline int result() {
+        return failures == 0 ? 0 : 1;
+    }
+}
+
+#endif //AWESOME_VIEWER_CHECK_H
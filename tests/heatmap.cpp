@@ -0,0 +1,69 @@
+//
+// Created by terae on 19/10/26.
+//
+
+#include "check.hpp"
+
+#include "HeatmapCell.hpp"
+
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <vector>
+
+using namespace AwesomeViewer;
+using namespace AwesomeViewer::Test;
+
+namespace {
+    constexpr float inf = std::numeric_limits<float>::infinity();
+    constexpr float nan = std::numeric_limits<float>::quiet_NaN();
+
+    void check_quantize() {
+        const std::vector<float> values = {-inf, -1.0f, 0.0f, 0.5f, 1.0f, 2.5f, 4.0f, 100.0f, inf, nan};
+        const std::vector<std::uint8_t> expected = {0, 0, 0, 0, 1, 2, 4, 4, 4, 0};
+        std::vector<std::uint8_t> levels(values.size());
+        quantize(values.data(), levels.data(), values.size(), 0.0f, 1.0f, 5);
+        for (std::size_t i = 0; i < values.size(); ++i) {
+            check(levels[i] == expected[i], std::to_string(values[i]) + " at level " + std::to_string(levels[i]) +
+                  " instead of " + std::to_string(expected[i]));
+        }
+    }
+
+    std::string render(const std::vector<float> &values, float *lowest = nullptr, float *highest = nullptr) {
+        HeatmapCell cell(static_cast<unsigned int>(values.size()), 1, [&values]() {
+            return MatrixView(values.data(), 1, values.size());
+        }, HeatmapCell::Palette::Basic);
+        cell.update();
+        NumberExporter exporter;
+        cell.export_to(exporter);
+        if (lowest != nullptr) {
+            *lowest = static_cast<float>(exporter.values["min"]);
+            *highest = static_cast<float>(exporter.values["max"]);
+        }
+        return cell.get_nth_line(0);
+    }
+
+    // The range is the one of the finite values: infinities are at the ends of the scale and NaN at its start
+    void check_non_finite() {
+        float lowest = 0.0f, highest = 0.0f;
+        const auto line = render({0.0f, 1.0f, inf, nan, 4.0f, -inf}, &lowest, &highest);
+        check(lowest == 0.0f && highest == 4.0f, "the range ignores the non-finite values: " +
+              std::to_string(lowest) + " to " + std::to_string(highest));
+        check(line == render({0.0f, 1.0f, 4.0f, 0.0f, 4.0f, 0.0f}), "inf at the last level, NaN and -inf at the first");
+        check(line != render({0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f}), "an infinite value doesn't collapse the scale");
+
+        render({nan, inf}, &lowest, &highest);
+        check(lowest == 0.0f && highest == 0.0f, "an empty range without finite values");
+
+        // The range of the extreme floats overflows a float
+        const float max = std::numeric_limits<float>::max();
+        check(render({-max, max}) != render({0.0f, 0.0f}), "the range of the extreme floats is kept");
+    }
+}
+
+int main() {
+    check_quantize();
+    check_non_finite();
+
+    return result();
+}
@@ -0,0 +1,113 @@
+//
+// Created by terae on 19/10/26.
+//
+
+#include "check.hpp"
+
+#include "HistogramCell.hpp"
+#include "Width.hpp"
+
+#include <cstdint>
+#include <limits>
+#include <string>
+
+using namespace AwesomeViewer;
+using namespace AwesomeViewer::Test;
+
+namespace {
+    using Histogram = LatencyHistogram;
+
+    // `value` is in the range of its bucket, which is less than 1/64 of its lowest value wide
+    void check_bucket(std::uint64_t value) {
+        const auto bucket = Histogram::bucket_of(value);
+        const auto name = "value " + std::to_string(value) + " in bucket " + std::to_string(bucket);
+        check(bucket < Histogram::bucket_count, name + ": out of the buckets");
+        check(Histogram::lowest_of(bucket) <= value && value <= Histogram::highest_of(bucket),
+              name + ": not in the range of the bucket");
+        check((Histogram::highest_of(bucket) - Histogram::lowest_of(bucket)) * Histogram::sub_buckets <=
+              Histogram::lowest_of(bucket), name + ": bucket too wide");
+    }
+
+    void check_buckets() {
+        check(Histogram::bucket_of(0) == 0 && Histogram::highest_of(0) == 0, "0 has its own bucket");
+        // Exact below 2^precision_bits
+        const std::uint64_t exact = std::uint64_t(1) << Histogram::precision_bits;
+        for (std::uint64_t value = 0; value < exact; ++value) {
+            check(Histogram::lowest_of(Histogram::bucket_of(value)) == value &&
+                  Histogram::highest_of(Histogram::bucket_of(value)) == value,
+                  std::to_string(value) + " has its own bucket");
+        }
+        for (unsigned int bits = Histogram::precision_bits; bits < Histogram::max_bits; ++bits) {
+            const std::uint64_t power = std::uint64_t(1) << bits;
+            check_bucket(power - 1);
+            check_bucket(power);
+            check_bucket(power + 1);
+        }
+        check_bucket(Histogram::max_value);
+        check(Histogram::bucket_of(exact - 1) + 1 == Histogram::bucket_of(exact), "no gap after the exact buckets");
+
+        // The last bucket saturates
+        const auto last = Histogram::bucket_count - 1;
+        check(Histogram::bucket_of(Histogram::max_value) == last, "max_value is in the last bucket");
+        check(Histogram::highest_of(last) == Histogram::max_value, "the last bucket ends at max_value");
+        check(Histogram::bucket_of(Histogram::max_value + 1) == last &&
+              Histogram::bucket_of(std::numeric_limits<std::uint64_t>::max()) == last,
+              "the values over max_value are saturated");
+    }
+
+    void check_percentiles() {
+        Histogram histogram;
+        Histogram::Snapshot snapshot;
+        histogram.snapshot(snapshot);
+        check(snapshot.total() == 0 && snapshot.percentile(50.0) == 0, "the percentiles of nothing are 0");
+
+        for (std::uint64_t value = 1; value <= 1000; ++value) {
+            histogram.record(value * 1000);
+        }
+        histogram.snapshot(snapshot);
+        check(snapshot.total() == 1000, "every value is counted");
+        const auto p50 = snapshot.percentile(50.0);
+        check(p50 >= 500000 && p50 <= Histogram::highest_of(Histogram::bucket_of(500000)),
+              "p50 is the highest value of the bucket of the median: " + std::to_string(p50));
+        check(snapshot.percentile(0.0) == Histogram::highest_of(Histogram::bucket_of(1000)),
+              "p0 is the bucket of the lowest value");
+        check(snapshot.percentile(100.0) == Histogram::highest_of(Histogram::bucket_of(1000000)),
+              "p100 is the bucket of the highest value");
+
+        histogram.record(std::numeric_limits<std::uint64_t>::max());
+        histogram.snapshot(snapshot);
+        check(snapshot.percentile(100.0) == Histogram::max_value, "a saturated value is max_value");
+
+        // Only the values recorded since a previous snapshot
+        Histogram::Snapshot previous = snapshot;
+        histogram.record(7);
+        histogram.snapshot(snapshot);
+        snapshot.subtract(previous);
+        check(snapshot.total() == 1 && snapshot.percentile(99.9) == 7, "subtract keeps the new values only");
+    }
+
+    // Every line takes the width of the cell, however narrow
+    void check_narrow() {
+        Histogram histogram;
+        histogram.record(1500);
+        for (unsigned int width = 1; width <= 30; ++width) {
+            for (unsigned int height = 1; height <= 5; ++height) {
+                HistogramCell cell(width, height, histogram);
+                cell.update();
+                for (std::size_t i = 0; i < height; ++i) {
+                    const auto line = strip_escapes(cell.get_nth_line(i));
+                    check(display_width(line) == width, "line " + std::to_string(i) + " of a histogram " +
+                          std::to_string(width) + "x" + std::to_string(height) + ": \"" + line + "\"");
+                }
+            }
+        }
+    }
+}
+
+int main() {
+    check_buckets();
+    check_percentiles();
+    check_narrow();
+
+    return result();
+}
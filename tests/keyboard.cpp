@@ -0,0 +1,90 @@
+//
+// Created by terae on 19/10/26.
+//
+
+#include "check.hpp"
+
+#include "Keyboard.hpp"
+
+#include <chrono>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdlib.h>
+#include <string>
+#include <sys/ioctl.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+using namespace AwesomeViewer;
+using namespace AwesomeViewer::Test;
+
+namespace {
+    using namespace std::chrono_literals;
+
+    // Typed on the terminal, then in the input of the keyboard once this returns
+    void type(int master, const std::string &keys) {
+        write(master, keys.data(), keys.size());
+        pollfd fd{STDIN_FILENO, POLLIN, 0};
+        poll(&fd, 1, 1000);
+    }
+
+    void check_keys(int master) {
+        Keyboard keyboard;
+        check(keyboard.is_enabled(), "the keyboard of a terminal in the foreground is enabled");
+
+        type(master, "a\e[");
+        check(keyboard.read_key(1000ms) == 'a', "a character");
+        check(keyboard.read_key(10ms) == NoKey, "no key for the beginning of an escape sequence");
+        type(master, "A");
+        check(keyboard.read_key(1000ms) == Up, "an arrow split across two reads is Up");
+
+        type(master, "\e");
+        check(keyboard.read_key(10ms) == NoKey, "a lone escape may be the beginning of a sequence");
+        type(master, "[5");
+        check(keyboard.read_key(10ms) == NoKey, "still incomplete");
+        type(master, "~\eOB\e[Z");
+        check(keyboard.read_key(1000ms) == PageUp, "a sequence split across three reads");
+        check(keyboard.read_key(0ms) == Down, "an SS3 sequence");
+        check(keyboard.read_key(0ms) == BackTab, "several sequences in one read");
+
+        // Nothing follows the escape: the Escape key after the delay
+        type(master, "\e");
+        const auto start = std::chrono::steady_clock::now();
+        const int key = keyboard.read_key(1000ms);
+        const auto elapsed = std::chrono::steady_clock::now() - start;
+        check(key == '\e', "a lone escape is the Escape key");
+        check(elapsed >= 25ms && elapsed < 500ms, "the Escape key after about 30 ms");
+
+        type(master, "\e[9~x\ey");
+        check(keyboard.read_key(1000ms) == 'x', "an unknown sequence is ignored");
+        check(keyboard.read_key(0ms) == '\e' && keyboard.read_key(0ms) == 'y',
+              "an escape followed by a character isn't a sequence");
+        check(keyboard.read_key(0ms) == NoKey, "nothing left");
+    }
+}
+
+int main() {
+    const int master = posix_openpt(O_RDWR | O_NOCTTY);
+    if (master < 0 || grantpt(master) != 0 || unlockpt(master) != 0) {
+        std::fprintf(stderr, "No pseudo-terminal, skipped\n");
+        return 0;
+    }
+
+    // The keyboard needs a terminal in the foreground: a new session, controlled by the pseudo-terminal
+    const pid_t child = fork();
+    if (child == 0) {
+        const int terminal = setsid() < 0 ? -1 : open(ptsname(master), O_RDWR);
+        if (terminal < 0 || ioctl(terminal, TIOCSCTTY, 0) != 0 || dup2(terminal, STDIN_FILENO) < 0) {
+            _exit(2);
+        }
+        alarm(10);
+        check_keys(master);
+        _exit(result());
+    }
+
+    int status = 0;
+    check(child > 0 && waitpid(child, &status, 0) == child && WIFEXITED(status) && WEXITSTATUS(status) == 0,
+          "the keys typed on a terminal are decoded");
+    close(master);
+    return result();
+}
@@ -0,0 +1,159 @@
+//
+// Created by terae on 19/10/26.
+//
+
+#include "check.hpp"
+
+#include "Cell.hpp"
+#include "Layout.hpp"
+#include "StaticTerminal.hpp"
+#include "utils.hpp"
+#include "Width.hpp"
+
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+using namespace AwesomeViewer;
+using namespace AwesomeViewer::Test;
+
+namespace {
+    // Every line of the layout takes exactly its width, whatever the names of the cells
+    void check_aligned(const std::string &name, unsigned int cell_width) {
+        Layout layout(20, 5);
+        layout.add_cell(std::make_shared<StringCell>(cell_width, 1, std::string("x")), name);
+        layout.update(AbstractCell::Clock::now());
+
+        std::string frame;
+        layout.compose(frame);
+        std::istringstream lines(strip_escapes(frame));
+        for (std::string line; std::getline(lines, line);) {
+            check(display_width(line) == 20, "\"" + name + "\" in a cell " + std::to_string(cell_width) +
+                  " wide: \"" + line + "\" isn't 20 columns wide");
+        }
+    }
+
+    // Same for a static dashboard, whose cells are rendered without a layout
+    void check_static_aligned() {
+        StaticTerminal terminal(20, 4, static_string_cell<6, 1>("s", []() { return std::string("héllo wörld"); }),
+                                static_string_cell<6, 1>("t", []() { return std::string("日本語"); }));
+        std::string frame;
+        terminal.render(frame);
+        std::istringstream lines(strip_escapes(frame));
+        for (std::string line; std::getline(lines, line);) {
+            check(display_width(line) == 20, "static dashboard: \"" + line + "\" isn't 20 columns wide");
+        }
+    }
+
+    // A copy displays the same cells, and highlighting a name in it leaves the original unchanged
+    void check_copy() {
+        Layout layout(30, 6);
+        auto cell = std::make_shared<StringCell>(5, 1, std::string("x"));
+        layout.add_cell(cell, "a");
+        layout.add_cell(std::make_shared<StringCell>(5, 2, std::string("y")), "b");
+        layout.update(AbstractCell::Clock::now());
+
+        Layout copy(layout);
+        std::string original_frame, copy_frame;
+        layout.compose(original_frame);
+        copy.compose(copy_frame);
+        check(original_frame == copy_frame, "a copy of the layout composes the same frame");
+
+        copy.set_focus(cell.get());
+        std::string after;
+        layout.compose(after);
+        copy_frame.clear();
+        copy.compose(copy_frame);
+        check(after == original_frame, "the focus of a copy doesn't change the original");
+        check(copy_frame != original_frame && strip_escapes(copy_frame) == strip_escapes(original_frame),
+              "the focus only changes the style of the name");
+    }
+
+    // With a limited budget, the cells are updated by decreasing priority, and not at all once it is cancelled
+    void check_priorities() {
+        Layout layout(40, 10);
+        std::string order;
+        FrameBudget *current = nullptr;
+        bool cancel = false;
+        auto add = [&](char name, Priority priority) {
+            auto cell = std::make_shared<StringCell>(5, 1, std::function<std::string()>([&, name]() {
+                order += name;
+                if (cancel && name == 'c') {
+                    current->cancel();
+                }
+                return std::string(1, name);
+            }));
+            cell->set_priority(priority);
+            layout.add_cell(cell, std::string(1, name));
+            return cell;
+        };
+        add('a', Priority::Low);
+        auto b = add('b', Priority::Normal);
+        add('c', Priority::High);
+        add('d', Priority::Critical);
+        add('e', Priority::Normal);
+
+        // Among the cells of the same priority, the least recently updated first
+        const auto now = AbstractCell::Clock::now();
+        b->refresh(now);
+        order.clear();
+        FrameBudget budget(std::chrono::hours(1));
+        layout.update(now, budget);
+        check(order == "dceba", "updated by priority: " + order);
+
+        // Only the critical cells once the budget is spent
+        FrameBudget spent(std::chrono::nanoseconds(1));
+        while (!spent.is_exhausted()) {
+        }
+        order.clear();
+        layout.update(now, spent);
+        check(order == "d" && spent.skipped == 4, "only the critical cells with a spent budget: " + order);
+
+        // No cell at all after the cancellation, whatever its priority
+        FrameBudget cancelled(std::chrono::hours(1));
+        current = &cancelled;
+        cancel = true;
+        order.clear();
+        layout.update(now, cancelled);
+        check(order == "dc" && cancelled.is_cancelled(), "no update after the cancellation: " + order);
+    }
+
+    template<class F>
+    bool throws_invalid_argument(F &&f) {
+        try {
+            f();
+        } catch (const std::invalid_argument &) {
+            return true;
+        }
+        return false;
+    }
+}
+
+int main() {
+    // A wide first character which doesn't fit in the name space
+    check_aligned("日本", 3);
+    check_aligned("日本", 4);
+    check_aligned("abc", 3);
+    check_aligned("é", 3);
+    check_aligned("", 1);
+    check_static_aligned();
+    check_copy();
+    check_priorities();
+
+    // Too narrow for a name
+    Layout layout(20, 5);
+    check(throws_invalid_argument([&layout]() {
+        layout.add_cell(std::make_shared<StringCell>(2, 1, std::string("x")), "name");
+    }), "a named cell 2 wide is rejected");
+    check(throws_invalid_argument([&layout]() {
+        layout.add_cell_at(std::make_shared<StringCell>(1, 1, std::string("x")), "name", 0, 0);
+    }), "a named cell 1 wide is rejected by add_cell_at");
+    check(!throws_invalid_argument([&layout]() {
+        layout.add_cell(std::make_shared<StringCell>(2, 1, std::string("x")));
+    }), "an unnamed cell 2 wide is accepted");
+
+    return result();
+}
@@ -0,0 +1,70 @@
+//
+// Created by terae on 19/10/26.
+//
+
+#include "check.hpp"
+
+#include "RateCell.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <string>
+
+using namespace AwesomeViewer;
+using namespace AwesomeViewer::Test;
+
+namespace {
+    bool near(double value, double expected) {
+        return std::abs(value - expected) <= 1e-9 * std::max(1.0, std::abs(expected));
+    }
+
+    void check_rate(const NumberExporter &exporter, const std::string &key, double expected) {
+        const auto it = exporter.values.find(key);
+        check(it != exporter.values.end() && near(it->second, expected), key + " is " +
+              (it == exporter.values.end() ? std::string("missing") : std::to_string(it->second)) + " instead of " +
+              std::to_string(expected));
+    }
+
+    // The averages at fixed elapsed times: plain before their window, then decaying by exp(-elapsed / window)
+    void check_ewma() {
+        Counter counter;
+        RateCell cell(60, 2, {{"requests", &counter}});
+        const auto start = RateCell::Clock::time_point{} + std::chrono::hours(1);
+
+        cell.update(start);
+        NumberExporter nothing;
+        cell.export_to(nothing);
+        check(nothing.values.empty(), "nothing is exported before a second sample");
+
+        counter.add(100);
+        cell.update(start + std::chrono::seconds(1));
+        NumberExporter first;
+        cell.export_to(first);
+        check_rate(first, "requests.now", 100.0);
+        check_rate(first, "requests.1s", 100.0 * (1.0 - std::exp(-1.0)));
+        check_rate(first, "requests.10s", 100.0);
+        check_rate(first, "requests.1m", 100.0);
+
+        // Without events, the 1s average decays by exp(-1) per second
+        cell.update(start + std::chrono::seconds(2));
+        NumberExporter second;
+        cell.export_to(second);
+        check_rate(second, "requests.now", 0.0);
+        check_rate(second, "requests.1s", 100.0 * (1.0 - std::exp(-1.0)) * std::exp(-1.0));
+        check_rate(second, "requests.10s", 50.0);
+
+        // A sample less than 1 ms after the previous one is ignored
+        counter.add(1000);
+        cell.update(start + std::chrono::seconds(2) + std::chrono::microseconds(10));
+        NumberExporter ignored;
+        cell.export_to(ignored);
+        check(ignored.values == second.values, "a sample too close to the previous one is ignored");
+    }
+}
+
+int main() {
+    check_ewma();
+
+    return result();
+}
@@ -0,0 +1,120 @@
+//
+// Created by terae on 19/10/26.
+//
+
+#include "check.hpp"
+
+#include "DashboardState.hpp"
+
+#include <cstdlib>
+#include <fcntl.h>
+#include <string>
+#include <unistd.h>
+
+using namespace AwesomeViewer;
+using namespace AwesomeViewer::Test;
+
+namespace {
+    void write_file(const std::string &path, const std::string &data) {
+        const int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0600);
+        write(fd, data.data(), data.size());
+        close(fd);
+    }
+
+    bool same_lines(const SavedCell &a, const SavedCell &b) {
+        if (a.lines.size() != b.lines.size()) {
+            return false;
+        }
+        for (std::size_t i = 0; i < a.lines.size(); ++i) {
+            const auto &x = a.lines[i].segments();
+            const auto &y = b.lines[i].segments();
+            if (x.size() != y.size()) {
+                return false;
+            }
+            for (std::size_t s = 0; s < x.size(); ++s) {
+                if (x[s].second != y[s].second || x[s].first.bg != y[s].first.bg || x[s].first.fg != y[s].first.fg ||
+                        x[s].first.font != y[s].first.font || x[s].first.bg_index != y[s].first.bg_index) {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    DashboardState make_state() {
+        DashboardState state;
+        state.width = 80;
+        state.height = 24;
+        state.frame = "frame\nwith \e[1mescapes\e[0m\n";
+        StyleString styled;
+        styled.insert(Style(Font::Bold, FontColor::Red), "bold");
+        styled.insert(Style::Default().with_background({196}), " indexed");
+        state.pages.push_back({"Main", {{"counter", 1, 2, 10, 2, {styled, StyleString(std::string("plain"))}},
+                                        {"empty", 0, 4, 5, 1, {}}}});
+        state.pages.push_back({"other", {}});
+        return state;
+    }
+
+    void check_round_trip(const std::string &path) {
+        const auto saved = make_state();
+        write_file(path, saved.serialize());
+        const auto loaded = DashboardState::load(path);
+        check(loaded.has_value(), "a saved state is loaded");
+        if (!loaded) {
+            return;
+        }
+        check(loaded->width == 80 && loaded->height == 24 && loaded->frame == saved.frame, "the size and the frame");
+        check(loaded->pages.size() == 2 && loaded->pages[0].name == "Main" && loaded->pages[1].name == "other" &&
+              loaded->pages[1].cells.empty(), "the pages");
+        if (loaded->pages.size() != 2 || loaded->pages[0].cells.size() != 2) {
+            check(false, "the cells of the first page");
+            return;
+        }
+        for (std::size_t i = 0; i < 2; ++i) {
+            const auto &a = saved.pages[0].cells[i];
+            const auto &b = loaded->pages[0].cells[i];
+            check(a.name == b.name && a.x == b.x && a.y == b.y && a.width == b.width && a.height == b.height,
+                  "the placement of " + a.name);
+            check(same_lines(a, b), "the styled lines of " + a.name);
+        }
+    }
+
+    // Only a whole state is loaded
+    void check_invalid(const std::string &path) {
+        const auto data = make_state().serialize();
+        for (std::size_t size = 0; size < data.size(); ++size) {
+            write_file(path, data.substr(0, size));
+            check(!DashboardState::load(path), "a state truncated to " + std::to_string(size) + " bytes is rejected");
+        }
+        write_file(path, data + '\0');
+        check(!DashboardState::load(path), "a state followed by other data is rejected");
+        auto corrupted = data;
+        corrupted[0] = 'X';
+        write_file(path, corrupted);
+        check(!DashboardState::load(path), "a file without the magic is rejected");
+
+        write_file(path, data);
+        const auto link = path + ".link";
+        symlink(path.c_str(), link.c_str());
+        check(!DashboardState::load(link), "a state isn't loaded through a link");
+        unlink(link.c_str());
+        unlink(path.c_str());
+        check(!DashboardState::load(path), "no state without file");
+    }
+}
+
+int main() {
+    char directory[] = "/tmp/awesome-viewer-state-XXXXXX";
+    if (mkdtemp(directory) == nullptr) {
+        std::fprintf(stderr, "Unable to create a directory\n");
+        return 1;
+    }
+    const std::string path = std::string(directory) + "/state";
+
+    check_round_trip(path);
+    check_invalid(path);
+
+    unlink(path.c_str());
+    rmdir(directory);
+    return result();
+}
@@ -0,0 +1,70 @@
+//
+// Created by terae on 19/10/26.
+//
+
+#include "check.hpp"
+
+#include "Cell.hpp"
+#include "StaticTerminal.hpp"
+#include "VirtualTerminal.hpp"
+#include "utils.hpp"
+
+#include <functional>
+#include <string>
+#include <string_view>
+
+using namespace AwesomeViewer;
+using namespace AwesomeViewer::Test;
+
+namespace {
+    // The same dashboard displays the same text in both terminals, whatever the content of its cells
+    void check_same_text() {
+        int frame = 0;
+        auto text = [&frame]() {
+            return (frame % 2 ? "Frame " : "Trame ü ") + std::to_string(frame) + "\nof the tést, longer than the cell";
+        };
+        auto number = [&frame]() {
+            return std::to_string(frame * 7 % 1000);
+        };
+        auto progress = [&frame]() {
+            return static_cast<double>(frame * 13 % 120) - 10.0;
+        };
+
+        VirtualTerminal dynamic(80, 12);
+        StringCell c1(20, 2, std::function<std::string()>(text));
+        StringCell c2(10, 1, std::function<std::string()>(number));
+        StringCell c3(30, 1, std::string("日本語 content"));
+        ProgressCell c4(24, 1, std::function<double()>(progress));
+        dynamic.add_cell(c1, "Text");
+        dynamic.add_cell(c2, "Number");
+        dynamic.add_cell(c3, "Constant");
+        dynamic.add_cell(c4, "Progress");
+
+        StaticTerminal static_terminal(80, 12,
+                                       static_string_cell<20, 2>("Text", text),
+                                       static_string_cell<10, 1>("Number", number),
+                                       static_string_cell<30, 1>("Constant", []() {
+            return std::string_view("日本語 content");
+        }),
+        static_progress_cell<24>("Progress", progress));
+
+        std::string dynamic_frame, static_frame;
+        for (frame = 0; frame < 20; ++frame) {
+            dynamic.render(dynamic_frame);
+            static_terminal.render(static_frame);
+            check(strip_escapes(dynamic_frame) == strip_escapes(static_frame), "frame " + std::to_string(frame) +
+                  ":\n" + strip_escapes(dynamic_frame) + "\ninstead of:\n" + strip_escapes(static_frame));
+        }
+
+        dynamic.remove_cell(c1);
+        dynamic.remove_cell(c2);
+        dynamic.remove_cell(c3);
+        dynamic.remove_cell(c4);
+    }
+}
+
+int main() {
+    check_same_text();
+
+    return result();
+}
@@ -0,0 +1,69 @@
+//
+// Created by terae on 19/10/26.
+//
+
+#include "check.hpp"
+
+#include "TaskProgressCell.hpp"
+#include "utils.hpp"
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+using namespace AwesomeViewer;
+using namespace AwesomeViewer::Test;
+
+namespace {
+    std::string line(const AbstractCell &cell, std::size_t n) {
+        return strip_escapes(cell.get_nth_line(n));
+    }
+
+    // The ETA from the throughput since the first frame, and the least advanced tasks by increasing progress
+    void check_progress() {
+        using namespace std::chrono_literals;
+        TaskSet tasks({10, 100, 100, 190});
+        TaskProgressCell cell(60, 5, tasks);
+        const auto start = TaskProgressCell::Clock::time_point{} + 1h;
+        cell.update(start);
+        check(line(cell, 1).find("ETA -") != std::string::npos, "no ETA without throughput: " + line(cell, 1));
+
+        tasks.advance(0, 10);
+        tasks.advance(1, 5);
+        tasks.advance(2, 20);
+        tasks.advance(3, 5);
+        cell.update(start + 1s);
+
+        NumberExporter exporter;
+        cell.export_to(exporter);
+        check(exporter.values["done"] == 40 && exporter.values["total"] == 400 && exporter.values["finished"] == 1,
+              "the tasks are aggregated");
+        check(exporter.values["throughput"] == 40.0, "40 per second during the first second");
+        // 360 remaining at 40 per second
+        check(line(cell, 1).find("ETA 9s") != std::string::npos, "ETA of 9 s: " + line(cell, 1));
+
+        const std::vector<std::string> slowest = {"#3 ", "#1 ", "#2 "};
+        for (std::size_t i = 0; i < slowest.size(); ++i) {
+            check(line(cell, i + 2).starts_with(slowest[i]), "slowest task " + std::to_string(i) + ": " +
+                  line(cell, i + 2));
+        }
+
+        // The slowest tasks fitting in the height only
+        TaskProgressCell short_cell(60, 3, tasks);
+        short_cell.update(start);
+        check(line(short_cell, 2).starts_with("#3 "), "the slowest task in a cell of one task: " + line(short_cell, 2));
+
+        tasks.set_done(1, 100);
+        tasks.set_done(2, 100);
+        tasks.set_done(3, 190);
+        cell.update(start + 2s);
+        check(line(cell, 1).find("done") != std::string::npos, "done once every task is: " + line(cell, 1));
+        check(line(cell, 2).find_first_not_of(' ') == std::string::npos, "no slowest task once they are all done");
+    }
+}
+
+int main() {
+    check_progress();
+
+    return result();
+}
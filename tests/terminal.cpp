@@ -0,0 +1,193 @@
+//
+// Created by terae on 19/10/26.
+//
+
+#include "check.hpp"
+
+#include "Cell.hpp"
+#include "VirtualTerminal.hpp"
+
+#include <chrono>
+#include <fcntl.h>
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include <stdlib.h>
+#include <string>
+#include <sys/ioctl.h>
+#include <thread>
+#include <unistd.h>
+
+using namespace AwesomeViewer;
+using namespace AwesomeViewer::Test;
+
+namespace {
+    // The standard output is a pseudo-terminal while it exists, so that the frames are displayed
+    class PseudoTerminal {
+        int _master = -1;
+        int _terminal = -1;
+        int _standard_output = -1;
+        std::thread _reader;
+
+      public:
+        PseudoTerminal(unsigned short columns, unsigned short rows) {
+            _master = posix_openpt(O_RDWR | O_NOCTTY);
+            if (_master < 0 || grantpt(_master) != 0 || unlockpt(_master) != 0) {
+                throw std::runtime_error("Unable to open a pseudo-terminal.");
+            }
+            _terminal = open(ptsname(_master), O_WRONLY | O_NOCTTY);
+            winsize size{};
+            size.ws_col = columns;
+            size.ws_row = rows;
+            ioctl(_terminal, TIOCSWINSZ, &size);
+            _reader = std::thread([master = _master]() {
+                char buffer[4096];
+                while (read(master, buffer, sizeof(buffer)) > 0) {
+                }
+            });
+            _standard_output = dup(STDOUT_FILENO);
+            dup2(_terminal, STDOUT_FILENO);
+        }
+
+        PseudoTerminal(const PseudoTerminal &) = delete;
+        PseudoTerminal &operator=(const PseudoTerminal &) = delete;
+
+        ~PseudoTerminal() {
+            dup2(_standard_output, STDOUT_FILENO);
+            close(_standard_output);
+            // The reader stops once the last descriptor of the terminal is closed
+            close(_terminal);
+            _reader.join();
+            close(_master);
+        }
+    };
+
+    // Everything written to the standard output while it exists, through a pipe
+    class Capture {
+        int _pipe[2] = {-1, -1};
+        int _standard_output = -1;
+        std::string _output;
+        std::thread _reader;
+
+      public:
+        Capture() {
+            if (pipe(_pipe) != 0) {
+                throw std::runtime_error("Unable to create a pipe.");
+            }
+            _reader = std::thread([this]() {
+                char buffer[4096];
+                for (ssize_t n; (n = read(_pipe[0], buffer, sizeof(buffer))) > 0;) {
+                    _output.append(buffer, static_cast<std::size_t>(n));
+                }
+            });
+            _standard_output = dup(STDOUT_FILENO);
+            dup2(_pipe[1], STDOUT_FILENO);
+            close(_pipe[1]);
+        }
+
+        Capture(const Capture &) = delete;
+        Capture &operator=(const Capture &) = delete;
+
+        ~Capture() {
+            finish();
+            close(_pipe[0]);
+        }
+
+        // Restore the standard output, and return what was written
+        const std::string &finish() {
+            if (_standard_output != -1) {
+                dup2(_standard_output, STDOUT_FILENO);
+                close(_standard_output);
+                _standard_output = -1;
+                _reader.join();
+            }
+            return _output;
+        }
+    };
+
+    // A cell whose generator removes `victim` from `vt` the first time, and then destroys it
+    std::shared_ptr<StringCell> make_remover(VirtualTerminal &vt, std::unique_ptr<StringCell> &victim, bool &removed) {
+        return std::make_shared<StringCell>(10, 1, std::function<std::string()>([&vt, &victim, &removed]() {
+            if (victim) {
+                removed = vt.remove_cell(*victim);
+                victim.reset();
+            }
+            return std::string("remover");
+        }));
+    }
+
+    // A cell removed by the update of another one, while the frame is rendered by `print` or by `select_page`
+    void check_remove_during_update() {
+        PseudoTerminal terminal(80, 24);
+        VirtualTerminal vt(40, 10);
+        vt.set_presentation(Presentation::Inline);
+
+        auto victim = std::make_unique<StringCell>(5, 1, std::string("v"));
+        bool removed = false;
+        vt.add_cell(make_remover(vt, victim, removed), "remover");
+        vt.add_cell(*victim, "victim");
+        vt.print();
+        check(removed && !victim, "a cell is removed by the update of another one during print()");
+        check(!vt.remove_cell(StringCell(1, 1, std::string())), "an unknown cell isn't removed");
+
+        const auto page = vt.add_page("other");
+        auto other_victim = std::make_unique<StringCell>(5, 1, std::string("w"));
+        bool other_removed = false;
+        vt.add_cell(make_remover(vt, other_victim, other_removed), "remover", page);
+        vt.add_cell(*other_victim, "victim", page);
+        vt.select_page("other");
+        check(other_removed && !other_victim, "a cell is removed by the update of another one during select_page()");
+        check(vt.current_page() == page, "select_page() displays the page");
+    }
+
+    // Only the changed values of the displayed page are written, and a cell added again is written as a whole
+    void check_changes() {
+        Capture capture;
+        VirtualTerminal vt(40, 10);
+        vt.set_presentation(Presentation::Changes);
+        vt.set_snapshot_interval(std::chrono::steady_clock::duration::zero());
+
+        int value = 0;
+        StringCell counter(5, 1, std::function<std::string()>([&value]() {
+            return std::to_string(value);
+        }));
+        StringCell constant(5, 1, std::string("same"));
+        int hidden_updates = 0;
+        StringCell hidden(5, 1, std::function<std::string()>([&hidden_updates]() {
+            ++hidden_updates;
+            return std::string("h");
+        }));
+        vt.add_cell(counter, "counter");
+        vt.add_cell(constant, "constant");
+        vt.add_cell(hidden, "hidden", vt.add_page("other"));
+
+        vt.print();
+        value = 1;
+        vt.print();
+        vt.print();
+        vt.remove_cell(constant);
+        vt.add_cell(constant, "constant");
+        vt.print();
+        vt.remove_cell(counter);
+        vt.remove_cell(constant);
+        vt.remove_cell(hidden);
+
+        const std::string expected = "cell=Main/counter line0=0\n"
+                                     "cell=Main/constant line0=same\n"
+                                     "cell=Main/counter line0=1\n"
+                                     "cell=Main/constant line0=same\n";
+        const auto &output = capture.finish();
+        check(output == expected, "Changes wrote:\n" + output + "instead of:\n" + expected);
+        check(hidden_updates == 0, "the cells of a hidden page aren't updated by Changes");
+    }
+}
+
+int main() {
+    // A reading waiting for itself never ends
+    alarm(10);
+
+    check_remove_during_update();
+    check_changes();
+
+    return result();
+}